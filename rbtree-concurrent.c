@@ -0,0 +1,113 @@
+/*
+ * rbtree for one writer at a time and many lockless readers
+ *
+ * rbtree.c built with RB_CONCURRENT stores child links atomically and
+ * publishes new nodes with release order, so a reader always follows
+ * valid pointers. during a rotation it may take a wrong turn, miss a
+ * node or walk in a loop for a while, the sequence count tells it to
+ * retry.
+ */
+
+#include "rbtree-concurrent.h"
+
+#ifndef RB_CONCURRENT
+#error "build rbtree-concurrent.c and rbtree.c with -DRB_CONCURRENT"
+#endif
+
+// a valid rbtree is at most 2 * log2(n) deep
+#define MAX_DEPTH (2 * 8 * sizeof(long))
+
+#define READ_LINK(link) __atomic_load_n(&(link), __ATOMIC_ACQUIRE)
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__asm__ __volatile__("pause");
+#endif
+}
+
+void rb_ctree_init(struct rb_ctree *ctree)
+{
+	rb_init(&ctree->tree);
+	ctree->seq = 0;
+	pthread_mutex_init(&ctree->lock, NULL);
+}
+
+void rb_ctree_destroy(struct rb_ctree *ctree)
+{
+	pthread_mutex_destroy(&ctree->lock);
+}
+
+static inline void write_begin(struct rb_ctree *ctree)
+{
+	pthread_mutex_lock(&ctree->lock);
+	__atomic_store_n(&ctree->seq, ctree->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_end(struct rb_ctree *ctree)
+{
+	__atomic_store_n(&ctree->seq, ctree->seq + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&ctree->lock);
+}
+
+static inline unsigned long read_begin(struct rb_ctree *ctree)
+{
+	unsigned long seq;
+
+	while ((seq = __atomic_load_n(&ctree->seq, __ATOMIC_ACQUIRE)) & 1)
+		cpu_relax();
+	return seq;
+}
+
+static inline int read_retry(struct rb_ctree *ctree, unsigned long seq)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&ctree->seq, __ATOMIC_RELAXED) != seq;
+}
+
+int rb_ctree_insert(struct rb_ctree *ctree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	int ret;
+
+	write_begin(ctree);
+	ret = rb_insert(&ctree->tree, node, cmp);
+	write_end(ctree);
+	return ret;
+}
+
+void rb_ctree_delete(struct rb_ctree *ctree, struct rb_node *node)
+{
+	write_begin(ctree);
+	rb_delete(&ctree->tree, node);
+	write_end(ctree);
+}
+
+struct rb_node *rb_ctree_find(struct rb_ctree *ctree, const void *key,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	struct rb_node *node;
+	unsigned long seq;
+	unsigned int depth;
+	int ret;
+
+	while (1) {
+		seq = read_begin(ctree);
+		node = READ_LINK(ctree->tree.root);
+
+		for (depth = 0; node && depth < MAX_DEPTH; depth++) {
+			ret = cmp(node, key);
+			if (ret < 0)
+				node = READ_LINK(node->left);
+			else if (ret > 0)
+				node = READ_LINK(node->right);
+			else
+				break;
+		}
+
+		// too deep is only seen while the tree changes
+		if (!read_retry(ctree, seq) && depth < MAX_DEPTH)
+			return node;
+	}
+}
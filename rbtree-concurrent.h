@@ -0,0 +1,38 @@
+/*
+ * rbtree for one writer at a time and many lockless readers
+ *
+ * writers take a mutex and bump a sequence count around each change,
+ * readers walk the tree without locking and retry if a writer changed
+ * the tree meanwhile. nodes removed from the tree must not be freed
+ * while readers may still be walking them.
+ *
+ * rbtree.c must be built with -DRB_CONCURRENT for the atomic link
+ * stores the readers rely on, trees without readers don't pay for them.
+ */
+
+#ifndef RBTREE_CONCURRENT_H
+#define RBTREE_CONCURRENT_H
+
+#include <pthread.h>
+#include "rbtree.h"
+
+struct rb_ctree {
+	struct rb_tree tree;
+	unsigned long seq;	// odd while a writer is changing the tree
+	pthread_mutex_t lock;	// serializes writers
+};
+
+void rb_ctree_init(struct rb_ctree *ctree);
+
+void rb_ctree_destroy(struct rb_ctree *ctree);
+
+int rb_ctree_insert(struct rb_ctree *ctree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *));
+
+void rb_ctree_delete(struct rb_ctree *ctree, struct rb_node *node);
+
+// lockless, cmp must only read fields that don't change in the tree
+struct rb_node *rb_ctree_find(struct rb_ctree *ctree, const void *key,
+		int (*cmp)(struct rb_node *, const void *));
+
+#endif
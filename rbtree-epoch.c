@@ -0,0 +1,180 @@
+/*
+ * epoch based reclamation
+ *
+ * the global epoch only moves from e to e + 1 once every thread in a
+ * read section has entered it in epoch e. a node deferred in epoch e
+ * was unlinked before, so any reader that may still see it entered in
+ * e or earlier, and is gone once the epoch reaches e + 2.
+ */
+
+#include <sched.h>
+#include "rbtree-epoch.h"
+
+// poll every that many defers
+#define POLL_INTERVAL 64
+
+void rb_epoch_init(struct rb_epoch *domain)
+{
+	domain->epoch = 0;
+	domain->threads = NULL;
+	pthread_mutex_init(&domain->lock, NULL);
+}
+
+void rb_epoch_destroy(struct rb_epoch *domain)
+{
+	pthread_mutex_destroy(&domain->lock);
+}
+
+void rb_epoch_register(struct rb_epoch *domain, struct rb_epoch_thread *thr)
+{
+	int i;
+
+	thr->domain = domain;
+	thr->active = 0;
+	thr->nesting = 0;
+	thr->deferred = 0;
+	for (i = 0; i < 3; i++) {
+		thr->pending[i] = NULL;
+		thr->tag[i] = 0;
+	}
+
+	pthread_mutex_lock(&domain->lock);
+	thr->next = domain->threads;
+	domain->threads = thr;
+	pthread_mutex_unlock(&domain->lock);
+}
+
+void rb_epoch_unregister(struct rb_epoch_thread *thr)
+{
+	struct rb_epoch *domain = thr->domain;
+	struct rb_epoch_thread **p;
+
+	rb_epoch_barrier(thr);
+
+	pthread_mutex_lock(&domain->lock);
+	for (p = &domain->threads; *p; p = &(*p)->next)
+		if (*p == thr) {
+			*p = thr->next;
+			break;
+		}
+	pthread_mutex_unlock(&domain->lock);
+}
+
+void rb_epoch_enter(struct rb_epoch_thread *thr)
+{
+	unsigned long epoch;
+
+	if (thr->nesting++)
+		return;
+
+	epoch = __atomic_load_n(&thr->domain->epoch, __ATOMIC_RELAXED);
+	__atomic_store_n(&thr->active, epoch << 1 | 1, __ATOMIC_RELAXED);
+
+	// the tree must not be read before the epoch is visible
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void rb_epoch_exit(struct rb_epoch_thread *thr)
+{
+	if (--thr->nesting)
+		return;
+
+	__atomic_store_n(&thr->active, 0, __ATOMIC_RELEASE);
+}
+
+static void run_callbacks(struct rb_epoch_head *head)
+{
+	struct rb_epoch_head *next;
+
+	for (; head; head = next) {
+		next = head->next;
+		head->func(head);
+	}
+}
+
+// run the callbacks deferred in epoch e - 2 or earlier
+static void reclaim(struct rb_epoch_thread *thr, unsigned long epoch)
+{
+	struct rb_epoch_head *head;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		if (!thr->pending[i] || thr->tag[i] + 2 > epoch)
+			continue;
+		head = thr->pending[i];
+		thr->pending[i] = NULL;
+		run_callbacks(head);
+	}
+}
+
+void rb_epoch_poll(struct rb_epoch_thread *thr)
+{
+	struct rb_epoch *domain = thr->domain;
+	struct rb_epoch_thread *t;
+	unsigned long epoch, active;
+	int advance = 1;
+
+	thr->deferred = 0;
+
+	// pairs with the fence in rb_epoch_enter()
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	epoch = __atomic_load_n(&domain->epoch, __ATOMIC_ACQUIRE);
+
+	pthread_mutex_lock(&domain->lock);
+	for (t = domain->threads; t; t = t->next) {
+		active = __atomic_load_n(&t->active, __ATOMIC_ACQUIRE);
+		if ((active & 1) && (active >> 1) != epoch) {
+			advance = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&domain->lock);
+
+	if (advance && __atomic_compare_exchange_n(&domain->epoch, &epoch,
+			epoch + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		epoch++;
+
+	reclaim(thr, epoch);
+}
+
+void rb_epoch_defer(struct rb_epoch_thread *thr, struct rb_epoch_head *head,
+		void (*func)(struct rb_epoch_head *head))
+{
+	unsigned long epoch;
+	int i;
+
+	// the node was unlinked before this load
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	epoch = __atomic_load_n(&thr->domain->epoch, __ATOMIC_ACQUIRE);
+	i = epoch % 3;
+
+	// the bucket still holds nodes from epoch - 3, they are due
+	if (thr->tag[i] != epoch) {
+		run_callbacks(thr->pending[i]);
+		thr->pending[i] = NULL;
+		thr->tag[i] = epoch;
+	}
+
+	head->func = func;
+	head->next = thr->pending[i];
+	thr->pending[i] = head;
+
+	if (++thr->deferred >= POLL_INTERVAL)
+		rb_epoch_poll(thr);
+}
+
+void rb_epoch_barrier(struct rb_epoch_thread *thr)
+{
+	while (thr->pending[0] || thr->pending[1] || thr->pending[2]) {
+		rb_epoch_poll(thr);
+		sched_yield();
+	}
+}
+
+void rb_delete_deferred(struct rb_ctree *ctree, struct rb_node *node,
+		struct rb_epoch_thread *thr, struct rb_epoch_head *head,
+		void (*func)(struct rb_epoch_head *head))
+{
+	rb_ctree_delete(ctree, node);
+	rb_epoch_defer(thr, head, func);
+}
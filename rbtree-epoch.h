@@ -0,0 +1,70 @@
+/*
+ * epoch based reclamation for nodes removed from an rb_ctree
+ *
+ * readers run lookups between rb_epoch_enter() and rb_epoch_exit().
+ * a writer hands removed nodes to rb_epoch_defer() (or removes them
+ * with rb_delete_deferred()), the callback runs once every reader that
+ * may have seen the node has left its read section. nothing blocks,
+ * deferred nodes are freed as the epoch advances on later defers.
+ */
+
+#ifndef RBTREE_EPOCH_H
+#define RBTREE_EPOCH_H
+
+#include <pthread.h>
+#include "rbtree-concurrent.h"
+
+// embed in the object to free, like the kernel's rcu_head
+struct rb_epoch_head {
+	struct rb_epoch_head *next;
+	void (*func)(struct rb_epoch_head *head);
+};
+
+struct rb_epoch_thread;
+
+struct rb_epoch {
+	unsigned long epoch;
+	pthread_mutex_t lock;		// protects the thread list
+	struct rb_epoch_thread *threads;
+};
+
+// per thread state, one per thread and domain
+struct rb_epoch_thread {
+	struct rb_epoch_thread *next;
+	struct rb_epoch *domain;
+	unsigned long active;		// epoch << 1 | 1 in a read section
+	int nesting;
+	unsigned long deferred;		// defers since the last poll
+	// nodes deferred in epoch tag[i], i = epoch % 3
+	struct rb_epoch_head *pending[3];
+	unsigned long tag[3];
+};
+
+void rb_epoch_init(struct rb_epoch *domain);
+
+void rb_epoch_destroy(struct rb_epoch *domain);
+
+void rb_epoch_register(struct rb_epoch *domain, struct rb_epoch_thread *thr);
+
+// waits until the nodes deferred by thr are freed
+void rb_epoch_unregister(struct rb_epoch_thread *thr);
+
+// read sections may nest
+void rb_epoch_enter(struct rb_epoch_thread *thr);
+void rb_epoch_exit(struct rb_epoch_thread *thr);
+
+void rb_epoch_defer(struct rb_epoch_thread *thr, struct rb_epoch_head *head,
+		void (*func)(struct rb_epoch_head *head));
+
+// try to advance the epoch and run the callbacks that are due
+void rb_epoch_poll(struct rb_epoch_thread *thr);
+
+// wait until all nodes deferred by thr so far are freed
+void rb_epoch_barrier(struct rb_epoch_thread *thr);
+
+// remove node from ctree and free it with func once no reader sees it
+void rb_delete_deferred(struct rb_ctree *ctree, struct rb_node *node,
+		struct rb_epoch_thread *thr, struct rb_epoch_head *head,
+		void (*func)(struct rb_epoch_head *head));
+
+#endif
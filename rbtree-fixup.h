@@ -0,0 +1,425 @@
+/*
+ * the rebalancing of rbtree.c, written once over accessor macros and
+ * included by each tree layout that links nodes its own way. no include
+ * guard, a file includes it once after defining:
+ *
+ * RB_FIX_TREE			tree type, e.g. struct rb_tree
+ * RB_FIX_REF			node reference, NIL must test false. a
+ *				pointer type, so one per declaration
+ * RB_FIX_NIL			the nil reference
+ * RB_FIX_ROOT(t), RB_FIX_SET_ROOT(t, n)
+ * RB_FIX_PARENT(t, n), RB_FIX_SET_PARENT(t, n, p)
+ * RB_FIX_COLOR(t, n), RB_FIX_SET_COLOR(t, n, c)
+ * RB_FIX_LEFT(t, n), RB_FIX_SET_LEFT(t, n, c)
+ * RB_FIX_RIGHT(t, n), RB_FIX_SET_RIGHT(t, n, c)
+ *				the SET_LEFT/RIGHT/ROOT link stores
+ * RB_FIX_AUG_ROTATE(old, new), RB_FIX_AUG_COPY(old, new),
+ * RB_FIX_AUG_UNLINKED(parent, n)
+ *				augment hooks, they may use aug
+ *
+ * it defines replace(), rotate(), insert_fixup(), delete_fixup() and
+ * delete_node(), all static, and undefines the macros again.
+ */
+
+#define T		RB_FIX_TREE
+#define REF		RB_FIX_REF
+#define NIL		RB_FIX_NIL
+#define PARENT(n)	RB_FIX_PARENT(tree, n)
+#define COLOR(n)	RB_FIX_COLOR(tree, n)
+#define LEFT(n)		RB_FIX_LEFT(tree, n)
+#define RIGHT(n)	RB_FIX_RIGHT(tree, n)
+#define SET_PARENT(n, p)	RB_FIX_SET_PARENT(tree, n, p)
+#define SET_COLOR(n, c)	RB_FIX_SET_COLOR(tree, n, c)
+#define SET_LEFT(n, c)	RB_FIX_SET_LEFT(tree, n, c)
+#define SET_RIGHT(n, c)	RB_FIX_SET_RIGHT(tree, n, c)
+
+// nil links are BLACK
+#define IS_RED(n)	((n) && COLOR(n) == RB_RED)
+
+static inline void replace(T *tree, REF old, REF new)
+{
+	REF parent = PARENT(old);
+
+	if (old == RB_FIX_ROOT(tree))
+		RB_FIX_SET_ROOT(tree, new);
+	else if (old == LEFT(parent))
+		SET_LEFT(parent, new);
+	else
+		SET_RIGHT(parent, new);
+	if (new)
+		SET_PARENT(new, parent);
+}
+
+// aug->rotate(old, new) is called once new took old's place as the
+// subtree root, with old's children already final
+static inline void rotate(T *tree, REF x,
+		const struct rb_augment_callbacks *aug)
+{
+	REF p = PARENT(x);
+	REF g = PARENT(p);
+
+	if (p == LEFT(g)) {
+		// Left left case
+		if (x == LEFT(p)) {
+			SET_COLOR(p, RB_BLACK);
+			SET_COLOR(g, RB_RED);
+			SET_LEFT(g, RIGHT(p));
+			if (RIGHT(p))
+				SET_PARENT(RIGHT(p), g);
+			SET_RIGHT(p, g);
+			replace(tree, g, p);
+			SET_PARENT(g, p);
+			RB_FIX_AUG_ROTATE(g, p);
+		}
+
+		// Left right case
+		else {
+			SET_COLOR(x, RB_BLACK);
+			SET_COLOR(g, RB_RED);
+			SET_RIGHT(p, LEFT(x));
+			if (LEFT(x))
+				SET_PARENT(LEFT(x), p);
+			SET_LEFT(g, RIGHT(x));
+			if (RIGHT(x))
+				SET_PARENT(RIGHT(x), g);
+			SET_LEFT(x, p);
+			SET_RIGHT(x, g);
+			replace(tree, g, x);
+			SET_PARENT(p, x);
+			SET_PARENT(g, x);
+			RB_FIX_AUG_ROTATE(p, x);
+			RB_FIX_AUG_ROTATE(g, x);
+		}
+	}
+
+	else {
+		// Right left case
+		if (x == LEFT(p)) {
+			SET_COLOR(x, RB_BLACK);
+			SET_COLOR(g, RB_RED);
+			SET_LEFT(p, RIGHT(x));
+			if (RIGHT(x))
+				SET_PARENT(RIGHT(x), p);
+			SET_RIGHT(g, LEFT(x));
+			if (LEFT(x))
+				SET_PARENT(LEFT(x), g);
+			SET_LEFT(x, g);
+			SET_RIGHT(x, p);
+			replace(tree, g, x);
+			SET_PARENT(p, x);
+			SET_PARENT(g, x);
+			RB_FIX_AUG_ROTATE(p, x);
+			RB_FIX_AUG_ROTATE(g, x);
+		}
+
+		// Right right case
+		else {
+			SET_COLOR(p, RB_BLACK);
+			SET_COLOR(g, RB_RED);
+			SET_RIGHT(g, LEFT(p));
+			if (LEFT(p))
+				SET_PARENT(LEFT(p), g);
+			SET_LEFT(p, g);
+			replace(tree, g, p);
+			SET_PARENT(g, p);
+			RB_FIX_AUG_ROTATE(g, p);
+		}
+	}
+}
+
+// rebalance after node is linked as a RED leaf below parent,
+// returns 1 if the black height of the tree grew
+static inline int insert_fixup(T *tree, REF node, REF parent,
+		const struct rb_augment_callbacks *aug)
+{
+	// Condition 1, If x is the root, change the colour of x as BLACK
+	if (!parent) {
+		SET_COLOR(node, RB_BLACK);
+		return 1;
+	}
+
+	// Condition 2, If parent is BLACK, insert done
+
+	// Condition 3, parent is red
+	while (COLOR(parent) == RB_RED) {
+		REF uncle;
+		REF grandpa;
+
+		grandpa = PARENT(parent);
+		uncle = (parent == LEFT(grandpa)) ? RIGHT(grandpa) : LEFT(grandpa);
+
+		// 3.1 uncle is red
+		if (IS_RED(uncle)) {
+
+			// change parent and uncle to BLACK
+			SET_COLOR(parent, RB_BLACK);
+			SET_COLOR(uncle, RB_BLACK);
+
+			// 3.1.1 grandpa is root, insert done
+			if (grandpa == RB_FIX_ROOT(tree))
+				return 1;
+
+			// 3.1.2 grandpa is not root, change its color to RED
+			SET_COLOR(grandpa, RB_RED);
+
+			// set x to grandpa, and continue to check
+			node = grandpa;
+			parent = PARENT(node);
+
+			continue;
+		}
+
+		// 3.2 uncle is BLACK, we need recoloring and rotating
+		rotate(tree, node, aug);
+
+		// after recoloring and rotating, the tree is balanced
+		break;
+	}
+
+	return 0;
+}
+
+// restore the black height of p's subtree, one black short on the
+// side opposite to s, its other child
+static inline void delete_fixup(T *tree, REF p, REF s,
+		const struct rb_augment_callbacks *aug)
+{
+	REF m;
+
+	// rotating and recoloring
+	while (p) {
+		// sibling is black
+		if (!IS_RED(s))
+		{
+			// b) its both children are black
+			if (!s || (!IS_RED(LEFT(s)) && !IS_RED(RIGHT(s))))
+			{
+				REF parent;
+
+				if (s)
+					SET_COLOR(s, RB_RED);
+
+				if (COLOR(p) == RB_RED) {
+					SET_COLOR(p, RB_BLACK);
+					return;
+				}
+
+				parent = PARENT(p);
+				if (parent)
+					s = (p == LEFT(parent)) ? RIGHT(parent) : LEFT(parent);
+				p = parent;
+				continue;
+			}
+
+			// a) at least one child is red
+			if (s == RIGHT(p)) {
+				if (IS_RED(RIGHT(s))) {
+					SET_COLOR(RIGHT(s), RB_BLACK);
+					SET_COLOR(s, COLOR(p));
+					SET_COLOR(p, RB_BLACK);
+					SET_RIGHT(p, LEFT(s));
+					if (LEFT(s))
+						SET_PARENT(LEFT(s), p);
+					SET_LEFT(s, p);
+					replace(tree, p, s);
+					SET_PARENT(p, s);
+					RB_FIX_AUG_ROTATE(p, s);
+				}
+				else {
+					m = LEFT(s);
+					SET_COLOR(m, COLOR(p));
+					SET_COLOR(p, RB_BLACK);
+					replace(tree, p, m);
+					SET_RIGHT(p, LEFT(m));
+					if (LEFT(m))
+						SET_PARENT(LEFT(m), p);
+					SET_LEFT(s, RIGHT(m));
+					if (RIGHT(m))
+						SET_PARENT(RIGHT(m), s);
+					SET_LEFT(m, p);
+					SET_PARENT(p, m);
+					SET_RIGHT(m, s);
+					SET_PARENT(s, m);
+					RB_FIX_AUG_ROTATE(s, m);
+					RB_FIX_AUG_ROTATE(p, m);
+				}
+			}
+			else {
+				if (IS_RED(LEFT(s))) {
+					SET_COLOR(LEFT(s), RB_BLACK);
+					SET_COLOR(s, COLOR(p));
+					SET_COLOR(p, RB_BLACK);
+					SET_LEFT(p, RIGHT(s));
+					if (RIGHT(s))
+						SET_PARENT(RIGHT(s), p);
+					SET_RIGHT(s, p);
+					replace(tree, p, s);
+					SET_PARENT(p, s);
+					RB_FIX_AUG_ROTATE(p, s);
+				}
+				else {
+					m = RIGHT(s);
+					SET_COLOR(m, COLOR(p));
+					SET_COLOR(p, RB_BLACK);
+					replace(tree, p, m);
+					SET_LEFT(p, RIGHT(m));
+					if (RIGHT(m))
+						SET_PARENT(RIGHT(m), p);
+					SET_RIGHT(s, LEFT(m));
+					if (LEFT(m))
+						SET_PARENT(LEFT(m), s);
+					SET_RIGHT(m, p);
+					SET_PARENT(p, m);
+					SET_LEFT(m, s);
+					SET_PARENT(s, m);
+					RB_FIX_AUG_ROTATE(s, m);
+					RB_FIX_AUG_ROTATE(p, m);
+				}
+			}
+
+			return;
+		}
+
+		else {
+			// c) sibling is red
+			replace(tree, p, s);
+
+			SET_PARENT(p, s);
+			SET_COLOR(p, RB_RED);
+			SET_COLOR(s, RB_BLACK);
+
+			if (s == RIGHT(p)) {
+				SET_RIGHT(p, LEFT(s));
+				if (LEFT(s))
+					SET_PARENT(LEFT(s), p);
+				SET_LEFT(s, p);
+				RB_FIX_AUG_ROTATE(p, s);
+				s = RIGHT(p); // update p s and continue
+			}
+			else {
+				SET_LEFT(p, RIGHT(s));
+				if (RIGHT(s))
+					SET_PARENT(RIGHT(s), p);
+				SET_RIGHT(s, p);
+				RB_FIX_AUG_ROTATE(p, s);
+				s = LEFT(p);
+			}
+		}
+	}
+}
+
+static inline void delete_node(T *tree, REF x,
+		const struct rb_augment_callbacks *aug)
+{
+	REF s;
+	REF p;
+	REF m;
+	REF n = NIL;
+
+	// Conditon 3, the deleted node has 2 childs
+	if (LEFT(x) && RIGHT(x))
+	{
+		int color = COLOR(x);
+
+		m = RIGHT(x);	// m is right child
+		n = m;
+		while (LEFT(n))
+			n = LEFT(n); // n is leftmost node
+
+		SET_COLOR(x, COLOR(n));
+		SET_COLOR(n, color);
+
+		SET_LEFT(n, LEFT(x));
+		if (LEFT(x))
+			SET_PARENT(LEFT(x), n);
+		SET_LEFT(x, NIL);
+		SET_RIGHT(x, RIGHT(n));
+
+		SET_RIGHT(n, m);
+		SET_PARENT(m, n);
+
+		m = PARENT(n);	// cache leftmost's parent to m
+		replace(tree, x, n);
+
+		if (RIGHT(n) == n) {	// leftmost is x's right child
+			SET_RIGHT(n, x);
+			SET_PARENT(x, n);
+		}
+		else {
+			SET_LEFT(m, x);
+			SET_PARENT(x, m);
+		}
+
+		RB_FIX_AUG_COPY(x, n);
+
+		// fallthrough to process leftmost deletion
+	}
+
+	// Condition 2, has only one child
+	if (LEFT(x) || RIGHT(x))
+	{
+		m = LEFT(x) ? LEFT(x) : RIGHT(x);
+		replace(tree, x, m);
+		RB_FIX_AUG_UNLINKED(PARENT(x), n);
+
+		// if any is red, delete done
+		if (COLOR(x) == RB_RED || COLOR(m) == RB_RED) {
+			SET_COLOR(m, RB_BLACK);
+			return;
+		}
+
+		// if both is black, fallthrough to fixup
+		p = m;
+		s = NIL;
+	}
+
+	// Condition 1, no child
+	else {
+		p = PARENT(x);
+		if (p)
+			s = (x == LEFT(p)) ? RIGHT(p) : LEFT(p);
+		else
+			s = NIL;
+
+		replace(tree, x, NIL);
+		RB_FIX_AUG_UNLINKED(p, n);
+
+		// 1.1 the deleted node is red, delete done
+		if (COLOR(x) == RB_RED)
+			return;
+
+		// 1.2 the deleted node is black, fallthrough to fixup
+	}
+
+	delete_fixup(tree, p, s, aug);
+}
+
+#undef T
+#undef REF
+#undef NIL
+#undef PARENT
+#undef COLOR
+#undef LEFT
+#undef RIGHT
+#undef SET_PARENT
+#undef SET_COLOR
+#undef SET_LEFT
+#undef SET_RIGHT
+#undef IS_RED
+
+#undef RB_FIX_TREE
+#undef RB_FIX_REF
+#undef RB_FIX_NIL
+#undef RB_FIX_ROOT
+#undef RB_FIX_SET_ROOT
+#undef RB_FIX_PARENT
+#undef RB_FIX_SET_PARENT
+#undef RB_FIX_COLOR
+#undef RB_FIX_SET_COLOR
+#undef RB_FIX_LEFT
+#undef RB_FIX_SET_LEFT
+#undef RB_FIX_RIGHT
+#undef RB_FIX_SET_RIGHT
+#undef RB_FIX_AUG_ROTATE
+#undef RB_FIX_AUG_COPY
+#undef RB_FIX_AUG_UNLINKED
@@ -0,0 +1,128 @@
+/*
+ * index linked rbtree
+ *
+ * the insert and delete fixups are those of rbtree.c, instantiated from
+ * rbtree-fixup.h over indices into the array.
+ */
+
+#include "rbtree-index.h"
+
+#define NODE(i)	rb_inode(tree, i)
+#define L(i)	NODE(i)->left
+#define R(i)	NODE(i)->right
+
+static inline uint32_t parent_of(const struct rb_itree *tree, uint32_t i)
+{
+	return NODE(i)->parent >> 1;
+}
+
+static inline int color_of(const struct rb_itree *tree, uint32_t i)
+{
+	return NODE(i)->parent & 1;
+}
+
+static inline void set_parent(struct rb_itree *tree, uint32_t i, uint32_t p)
+{
+	NODE(i)->parent = p << 1 | color_of(tree, i);
+}
+
+static inline void set_color(struct rb_itree *tree, uint32_t i, int color)
+{
+	NODE(i)->parent = (NODE(i)->parent & ~1u) | color;
+}
+
+uint32_t rb_itree_first(const struct rb_itree *tree)
+{
+	uint32_t i = tree->root;
+
+	if (!i)
+		return RB_INIL;
+	while (L(i))
+		i = L(i);
+	return i;
+}
+
+uint32_t rb_itree_next(const struct rb_itree *tree, uint32_t i)
+{
+	uint32_t p;
+
+	if (R(i)) {
+		i = R(i);
+		while (L(i))
+			i = L(i);
+		return i;
+	}
+
+	while ((p = parent_of(tree, i)) && i == R(p))
+		i = p;
+
+	return p;
+}
+
+uint32_t rb_itree_find(const struct rb_itree *tree, const void *key,
+		int (*cmp)(const struct rb_itree *, uint32_t, const void *))
+{
+	uint32_t i = tree->root;
+	int ret;
+
+	while (i) {
+		ret = cmp(tree, i, key);
+		if (ret < 0)
+			i = L(i);
+		else if (ret > 0)
+			i = R(i);
+		else
+			return i;
+	}
+
+	return RB_INIL;
+}
+
+// no augmentation, aug is always NULL
+#define RB_FIX_TREE			struct rb_itree
+#define RB_FIX_REF			uint32_t
+#define RB_FIX_NIL			RB_INIL
+#define RB_FIX_ROOT(t)			((t)->root)
+#define RB_FIX_SET_ROOT(t, n)		((t)->root = (n))
+#define RB_FIX_PARENT(t, n)		parent_of(t, n)
+#define RB_FIX_SET_PARENT(t, n, p)	set_parent(t, n, p)
+#define RB_FIX_COLOR(t, n)		color_of(t, n)
+#define RB_FIX_SET_COLOR(t, n, c)	set_color(t, n, c)
+#define RB_FIX_LEFT(t, n)		(rb_inode(t, n)->left)
+#define RB_FIX_SET_LEFT(t, n, c)	(rb_inode(t, n)->left = (c))
+#define RB_FIX_RIGHT(t, n)		(rb_inode(t, n)->right)
+#define RB_FIX_SET_RIGHT(t, n, c)	(rb_inode(t, n)->right = (c))
+#define RB_FIX_AUG_ROTATE(old, new)	((void)aug)
+#define RB_FIX_AUG_COPY(old, new)	((void)aug)
+#define RB_FIX_AUG_UNLINKED(p, n)	((void)aug)
+#include "rbtree-fixup.h"
+
+int rb_itree_insert(struct rb_itree *tree, uint32_t i,
+		int (*cmp)(const struct rb_itree *, uint32_t, uint32_t))
+{
+	uint32_t *link = &tree->root;
+	uint32_t p = RB_INIL;
+	int ret;
+
+	while (*link) {
+		p = *link;
+		ret = cmp(tree, p, i);
+		if (ret < 0)
+			link = &L(p);
+		else if (ret > 0)
+			link = &R(p);
+		else
+			return 0;
+	}
+
+	NODE(i)->left = NODE(i)->right = RB_INIL;
+	NODE(i)->parent = p << 1 | RB_RED;
+	*link = i;
+	insert_fixup(tree, i, p, NULL);
+	return 1;
+}
+
+void rb_itree_delete(struct rb_itree *tree, uint32_t x)
+{
+	delete_node(tree, x, NULL);
+}
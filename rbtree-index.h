@@ -0,0 +1,73 @@
+/*
+ * rbtree with 32 bit index links, for nodes kept in one array
+ *
+ * a node is three uint32_t, 12 bytes instead of 24. links are array
+ * indices, index 0 is the nil link so element 0 of the array is never
+ * a node, the color is the low bit of the parent link. at most 2^31 - 1
+ * nodes.
+ */
+
+#ifndef RBTREE_INDEX_H
+#define RBTREE_INDEX_H
+
+#include <stdint.h>
+#include "rbtree.h"
+
+#define RB_INIL	0
+
+struct rb_inode {
+	uint32_t parent;	// parent index << 1 | color
+	uint32_t left;
+	uint32_t right;
+};
+
+struct rb_itree {
+	uint32_t root;
+	char *base;		// node of element 0
+	size_t stride;		// element size
+};
+
+/*
+ * array is the element array, stride its element size and offset where
+ * the struct rb_inode sits in an element
+ */
+static inline void rb_itree_init(struct rb_itree *tree, void *array,
+		size_t stride, size_t offset)
+{
+	tree->root = RB_INIL;
+	tree->base = (char *)array + offset;
+	tree->stride = stride;
+}
+
+static inline struct rb_inode *rb_inode(const struct rb_itree *tree,
+		uint32_t i)
+{
+	return (struct rb_inode *)(tree->base + (size_t)i * tree->stride);
+}
+
+#define rb_ientry(tree, i, type, member) \
+	container_of(rb_inode(tree, i), type, member)
+
+static inline int rb_itree_empty(const struct rb_itree *tree)
+{
+	return tree->root == RB_INIL;
+}
+
+uint32_t rb_itree_first(const struct rb_itree *tree);
+
+uint32_t rb_itree_next(const struct rb_itree *tree, uint32_t i);
+
+// cmp(tree, i, key) < 0 if key sorts before node i, like rb_find()
+uint32_t rb_itree_find(const struct rb_itree *tree, const void *key,
+		int (*cmp)(const struct rb_itree *, uint32_t, const void *));
+
+// cmp(tree, a, b) < 0 if b sorts before a, like rb_insert()
+int rb_itree_insert(struct rb_itree *tree, uint32_t i,
+		int (*cmp)(const struct rb_itree *, uint32_t, uint32_t));
+
+void rb_itree_delete(struct rb_itree *tree, uint32_t i);
+
+#define rb_itree_for_each(i, tree) \
+	for (i = rb_itree_first(tree); i; i = rb_itree_next(tree, i))
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * search and insert with the comparator inlined
+ *
+ * RB_DECLARE_TREE() generates find, insert and next_from for one node
+ * type, the descent compares keys directly instead of calling through
+ * a function pointer, rebalancing is the same rbtree.c core.
+ *
+ * keyof(type *) gives the key of a node, cmp(keytype a, keytype b) is
+ * negative, 0 or positive as a is less, equal or greater than b.
+ *
+ *	struct item { struct rb_node node; long key; };
+ *	#define item_key(x) ((x)->key)
+ *	#define long_cmp(a, b) (((a) > (b)) - ((a) < (b)))
+ *	RB_DECLARE_TREE(items, struct item, node, long, item_key, long_cmp)
+ *
+ *	items_insert(&tree, x);
+ *	x = items_find(&tree, 42);
+ */
+
+#ifndef RBTREE_INLINE_H
+#define RBTREE_INLINE_H
+
+#include "rbtree.h"
+
+#define RB_DECLARE_TREE(name, type, member, keytype, keyof, cmp)	\
+static inline type *name ## _find(struct rb_tree *tree, keytype key)	\
+{									\
+	struct rb_node *node = tree->root;				\
+	int ret;							\
+									\
+	while (node) {							\
+		ret = cmp(key, keyof(rb_entry(node, type, member)));	\
+		if (ret < 0)						\
+			node = node->left;				\
+		else if (ret > 0)					\
+			node = node->right;				\
+		else							\
+			return rb_entry(node, type, member);		\
+	}								\
+									\
+	return (void *)0;						\
+}									\
+									\
+static inline type *name ## _next_from(struct rb_tree *tree,		\
+		keytype key)						\
+{									\
+	struct rb_node *node = tree->root, *want = (void *)0;		\
+									\
+	while (node) {							\
+		if (cmp(key, keyof(rb_entry(node, type, member))) < 0) {\
+			want = node;					\
+			node = node->left;				\
+		} else							\
+			node = node->right;				\
+	}								\
+									\
+	return want ? rb_entry(want, type, member) : (void *)0;	\
+}									\
+									\
+static inline int name ## _insert(struct rb_tree *tree, type *new)	\
+{									\
+	struct rb_node **link = &tree->root, *parent = (void *)0;	\
+	int ret;							\
+									\
+	while (*link) {							\
+		parent = *link;						\
+		ret = cmp(keyof(new),					\
+			keyof(rb_entry(parent, type, member)));		\
+		if (ret < 0)						\
+			link = &parent->left;				\
+		else if (ret > 0)					\
+			link = &parent->right;				\
+		else							\
+			return 0;					\
+	}								\
+									\
+	rb_link_node(&new->member, parent, link);			\
+	rb_insert_color(tree, &new->member);				\
+	return 1;							\
+}
+
+#endif
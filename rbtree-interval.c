@@ -0,0 +1,120 @@
+/*
+ * interval tree, an rbtree ordered by interval start and augmented with
+ * the max interval end of each subtree
+ */
+
+#include "rbtree-interval.h"
+
+#define IT(n) rb_interval_entry(n)
+
+static inline unsigned long compute_last(struct rb_interval_node *node)
+{
+	unsigned long max = node->last;
+
+	if (node->node.left && IT(node->node.left)->subtree_last > max)
+		max = IT(node->node.left)->subtree_last;
+	if (node->node.right && IT(node->node.right)->subtree_last > max)
+		max = IT(node->node.right)->subtree_last;
+	return max;
+}
+
+RB_DECLARE_CALLBACKS(static, interval_callbacks, struct rb_interval_node,
+		node, unsigned long, subtree_last, compute_last)
+
+// order by start, equal intervals are ordered by address
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (IT(r)->start != IT(l)->start)
+		return IT(r)->start < IT(l)->start ? -1 : 1;
+	return r < l ? -1 : (r > l);
+}
+
+void rb_interval_insert(struct rb_tree *tree, struct rb_interval_node *node)
+{
+	node->subtree_last = node->last;
+	rb_insert_augmented(tree, &node->node, cmp, &interval_callbacks);
+}
+
+void rb_interval_delete(struct rb_tree *tree, struct rb_interval_node *node)
+{
+	rb_delete_augmented(tree, &node->node, &interval_callbacks);
+}
+
+/*
+ * leftmost interval overlapping [start, last] in the subtree of node,
+ * given node->subtree_last >= start
+ *
+ * an interval [a, b] overlaps when a <= last and start <= b
+ */
+static struct rb_interval_node *subtree_search(struct rb_interval_node *node,
+		unsigned long start, unsigned long last)
+{
+	while (1) {
+		// an overlap on the left comes first in order
+		if (node->node.left) {
+			struct rb_interval_node *left = IT(node->node.left);
+
+			if (start <= left->subtree_last) {
+				node = left;
+				continue;
+			}
+		}
+
+		// nothing on the left, and everything after node starts
+		// after node->start
+		if (node->start > last)
+			return NULL;
+
+		if (start <= node->last)
+			return node;
+
+		if (!node->node.right)
+			return NULL;
+		node = IT(node->node.right);
+		if (start > node->subtree_last)
+			return NULL;
+	}
+}
+
+struct rb_interval_node *rb_interval_iter_first(struct rb_tree *tree,
+		unsigned long start, unsigned long last)
+{
+	struct rb_interval_node *node;
+
+	if (!tree->root)
+		return NULL;
+
+	node = IT(tree->root);
+	if (node->subtree_last < start)
+		return NULL;
+
+	return subtree_search(node, start, last);
+}
+
+struct rb_interval_node *rb_interval_iter_next(struct rb_interval_node *node,
+		unsigned long start, unsigned long last)
+{
+	struct rb_node *rb = node->node.right, *prev;
+
+	while (1) {
+		// everything on the right comes next, search it first
+		if (rb && start <= IT(rb)->subtree_last)
+			return subtree_search(IT(rb), start, last);
+
+		// go up until we come from a left child
+		do {
+			rb = rb_parent(&node->node);
+			if (!rb)
+				return NULL;
+			prev = &node->node;
+			node = IT(rb);
+			rb = node->node.right;
+		} while (prev == rb);
+
+		// node is the next in order, its left subtree is done
+		if (node->start > last)
+			return NULL;
+		if (start <= node->last)
+			return node;
+	}
+}
@@ -0,0 +1,38 @@
+/*
+ * interval tree, an rbtree ordered by interval start and augmented with
+ * the max interval end of each subtree
+ * overlap queries in O(log n + k)
+ */
+
+#ifndef RBTREE_INTERVAL_H
+#define RBTREE_INTERVAL_H
+
+#include "rbtree.h"
+
+// closed interval [start, last], duplicated intervals are allowed
+struct rb_interval_node {
+	struct rb_node node;
+	unsigned long start;
+	unsigned long last;
+	unsigned long subtree_last;
+};
+
+#define rb_interval_entry(n) rb_entry(n, struct rb_interval_node, node)
+
+void rb_interval_insert(struct rb_tree *tree, struct rb_interval_node *node);
+
+void rb_interval_delete(struct rb_tree *tree, struct rb_interval_node *node);
+
+// first interval overlapping [start, last], in order of interval start
+struct rb_interval_node *rb_interval_iter_first(struct rb_tree *tree,
+		unsigned long start, unsigned long last);
+
+// next interval after node overlapping [start, last]
+struct rb_interval_node *rb_interval_iter_next(struct rb_interval_node *node,
+		unsigned long start, unsigned long last);
+
+#define rb_interval_for_each(pos, tree, start, last) \
+	for (pos = rb_interval_iter_first(tree, start, last); pos; \
+		pos = rb_interval_iter_next(pos, start, last))
+
+#endif
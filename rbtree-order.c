@@ -0,0 +1,91 @@
+/*
+ * order statistic tree, a size augmented rbtree
+ */
+
+#include <limits.h>
+#include "rbtree-order.h"
+
+static inline unsigned long node_size(struct rb_node *node)
+{
+	return node ? rb_order_entry(node)->size : 0;
+}
+
+static inline unsigned long compute_size(struct rb_order_node *node)
+{
+	return 1 + node_size(node->node.left) + node_size(node->node.right);
+}
+
+RB_DECLARE_CALLBACKS(static, order_callbacks, struct rb_order_node, node,
+		unsigned long, size, compute_size)
+
+int rb_order_insert(struct rb_tree *tree, struct rb_order_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	node->size = 1;
+	return rb_insert_augmented(tree, &node->node, cmp, &order_callbacks);
+}
+
+void rb_order_delete(struct rb_tree *tree, struct rb_order_node *node)
+{
+	rb_delete_augmented(tree, &node->node, &order_callbacks);
+}
+
+struct rb_node *rb_select(struct rb_tree *tree, unsigned long k)
+{
+	struct rb_node *node = tree->root;
+	unsigned long left;
+
+	while (node) {
+		left = node_size(node->left);
+		if (k < left)
+			node = node->left;
+		else if (k > left) {
+			k -= left + 1;
+			node = node->right;
+		}
+		else
+			return node;
+	}
+
+	return NULL;
+}
+
+unsigned long rb_rank(struct rb_tree *tree, struct rb_node *node)
+{
+	unsigned long rank = node_size(node->left);
+	struct rb_node *parent;
+
+	// every time we come up from a right child, the parent and
+	// its left subtree are before node
+	while ((parent = rb_parent(node))) {
+		if (node == parent->right)
+			rank += node_size(parent->left) + 1;
+		node = parent;
+	}
+
+	// the climb ends at the root of the tree node is in
+	return node == tree->root ? rank : ULONG_MAX;
+}
+
+unsigned long rb_count_less(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	struct rb_node *node = tree->root;
+	unsigned long count = 0;
+	int ret;
+
+	while (node) {
+		ret = cmp(node, key);
+		if (ret < 0)
+			node = node->left;
+		else if (ret > 0) {
+			// node and its left subtree are less than key
+			count += node_size(node->left) + 1;
+			node = node->right;
+		}
+		else
+			return count + node_size(node->left);
+	}
+
+	return count;
+}
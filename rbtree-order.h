@@ -0,0 +1,38 @@
+/*
+ * order statistic tree, a size augmented rbtree
+ * rank and select in O(log n)
+ */
+
+#ifndef RBTREE_ORDER_H
+#define RBTREE_ORDER_H
+
+#include "rbtree.h"
+
+struct rb_order_node {
+	struct rb_node node;
+	unsigned long size;	// number of nodes in this subtree
+};
+
+#define rb_order_entry(n) rb_entry(n, struct rb_order_node, node)
+
+static inline unsigned long rb_order_size(struct rb_tree *tree)
+{
+	return tree->root ? rb_order_entry(tree->root)->size : 0;
+}
+
+int rb_order_insert(struct rb_tree *tree, struct rb_order_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *));
+
+void rb_order_delete(struct rb_tree *tree, struct rb_order_node *node);
+
+// the k-th smallest node, counting from 0, NULL if k >= size
+struct rb_node *rb_select(struct rb_tree *tree, unsigned long k);
+
+// number of nodes before node, ULONG_MAX if node is not in tree
+unsigned long rb_rank(struct rb_tree *tree, struct rb_node *node);
+
+// number of nodes less than key, cmp is the same as rb_find()
+unsigned long rb_count_less(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *));
+
+#endif
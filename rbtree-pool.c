@@ -0,0 +1,212 @@
+/*
+ * chunked node pool
+ *
+ * each chunk is one mmap() with its header in front, objects are handed
+ * out from the newest chunk in address order, so nodes inserted one
+ * after another sit next to each other in memory.
+ */
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include "rbtree-pool.h"
+
+#define HUGEPAGE_SIZE	(2UL << 20)
+#define CHUNK_SIZE	(64UL << 10)
+#define ALIGN		16
+
+struct rb_pool_chunk {
+	struct rb_pool_chunk *next;
+	size_t size;
+} __attribute__((aligned(ALIGN)));
+
+int rb_pool_init(struct rb_pool *pool, size_t size, size_t chunk_size,
+		int flags)
+{
+	// every object starts ALIGN aligned, like the first one after the
+	// chunk header, and is large enough for the free list link
+	if (size < sizeof(void *))
+		size = sizeof(void *);
+	size = (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+
+	if (!chunk_size)
+		chunk_size = flags & RB_POOL_HUGEPAGE ? HUGEPAGE_SIZE : CHUNK_SIZE;
+	if (flags & RB_POOL_HUGEPAGE)
+		chunk_size = (chunk_size + HUGEPAGE_SIZE - 1) & ~(HUGEPAGE_SIZE - 1);
+
+	if (chunk_size < sizeof(struct rb_pool_chunk) + size)
+		return -1;
+
+	pool->size = size;
+	pool->chunk_size = chunk_size;
+	pool->flags = flags;
+	pool->chunks = NULL;
+	pool->next = pool->end = NULL;
+	pool->free = NULL;
+	pool->nr_chunks = 0;
+	pthread_mutex_init(&pool->lock, NULL);
+	return 0;
+}
+
+static void *map_chunk(struct rb_pool *pool)
+{
+	size_t size = pool->chunk_size;
+	void *p;
+
+	if (!(pool->flags & RB_POOL_HUGEPAGE))
+		goto normal;
+
+#ifdef MAP_HUGETLB
+	// reserved huge pages first, they may not be configured
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (p != MAP_FAILED)
+		return p;
+#endif
+
+	// then transparent huge pages, map a spare page to align the chunk
+	p = mmap(NULL, size + HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+	{
+		uintptr_t start = (uintptr_t)p;
+		uintptr_t aligned = (start + HUGEPAGE_SIZE - 1) &
+			~(HUGEPAGE_SIZE - 1);
+
+		if (aligned > start)
+			munmap(p, aligned - start);
+		munmap((void *)(aligned + size), start + HUGEPAGE_SIZE - aligned);
+		p = (void *)aligned;
+	}
+#ifdef MADV_HUGEPAGE
+	madvise(p, size, MADV_HUGEPAGE);
+#endif
+	return p;
+
+normal:
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+void *rb_pool_alloc(struct rb_pool *pool)
+{
+	struct rb_pool_chunk *chunk;
+	void *obj;
+
+	if (pool->free) {
+		obj = pool->free;
+		pool->free = *(void **)obj;
+		return obj;
+	}
+
+	if (pool->end - pool->next < (ptrdiff_t)pool->size) {
+		chunk = map_chunk(pool);
+		if (!chunk)
+			return NULL;
+		chunk->size = pool->chunk_size;
+		chunk->next = pool->chunks;
+		pool->chunks = chunk;
+		pool->nr_chunks++;
+		pool->next = (char *)(chunk + 1);
+		pool->end = (char *)chunk + pool->chunk_size;
+	}
+
+	obj = pool->next;
+	pool->next += pool->size;
+	return obj;
+}
+
+void rb_pool_free(struct rb_pool *pool, void *obj)
+{
+	*(void **)obj = pool->free;
+	pool->free = obj;
+}
+
+void rb_pool_cache_init(struct rb_pool_cache *cache, struct rb_pool *pool)
+{
+	cache->pool = pool;
+	cache->free = NULL;
+	cache->nr_free = 0;
+}
+
+void *rb_pool_cache_alloc(struct rb_pool_cache *cache)
+{
+	struct rb_pool *pool = cache->pool;
+	void *obj;
+
+	// refill a batch under one lock
+	if (!cache->free) {
+		pthread_mutex_lock(&pool->lock);
+		while (cache->nr_free < RB_POOL_BATCH &&
+				(obj = rb_pool_alloc(pool))) {
+			*(void **)obj = cache->free;
+			cache->free = obj;
+			cache->nr_free++;
+		}
+		pthread_mutex_unlock(&pool->lock);
+		if (!cache->free)
+			return NULL;
+	}
+
+	obj = cache->free;
+	cache->free = *(void **)obj;
+	cache->nr_free--;
+	return obj;
+}
+
+// hand the first n cached objects back to the pool
+static void spill(struct rb_pool_cache *cache, size_t n)
+{
+	struct rb_pool *pool = cache->pool;
+	void *head = cache->free, **tail = &cache->free;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		tail = (void **)*tail;
+	cache->free = *tail;
+	cache->nr_free -= n;
+
+	pthread_mutex_lock(&pool->lock);
+	*tail = pool->free;
+	pool->free = head;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void rb_pool_cache_free(struct rb_pool_cache *cache, void *obj)
+{
+	*(void **)obj = cache->free;
+	cache->free = obj;
+	cache->nr_free++;
+
+	// keep a batch, so alternating alloc and free don't take the lock
+	if (cache->nr_free >= RB_POOL_BATCH * 2)
+		spill(cache, RB_POOL_BATCH);
+}
+
+void rb_pool_cache_flush(struct rb_pool_cache *cache)
+{
+	if (cache->nr_free)
+		spill(cache, cache->nr_free);
+}
+
+void rb_pool_destroy(struct rb_pool *pool)
+{
+	struct rb_pool_chunk *chunk, *next;
+
+	for (chunk = pool->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		munmap(chunk, chunk->size);
+	}
+
+	pool->chunks = NULL;
+	pool->next = pool->end = NULL;
+	pool->free = NULL;
+	pool->nr_chunks = 0;
+}
+
+void rb_destroy(struct rb_tree *tree, struct rb_pool *pool)
+{
+	tree->root = NULL;
+	rb_pool_destroy(pool);
+}
@@ -0,0 +1,78 @@
+/*
+ * fixed size node allocator for trees that own their nodes
+ *
+ * nodes are carved from large chunks, freed nodes go to a free list
+ * and are reused first. the whole pool is released a chunk at a time,
+ * so a tree whose nodes all come from one pool is destroyed without
+ * visiting them.
+ *
+ * rb_pool_alloc() and rb_pool_free() don't lock, they are for a pool
+ * used by one thread only. threads sharing a pool each go through
+ * their own rb_pool_cache, a free list that refills from and spills to
+ * the pool a batch at a time under its lock. a node may be freed to
+ * any thread's cache. don't mix the two on one pool.
+ */
+
+#ifndef RBTREE_POOL_H
+#define RBTREE_POOL_H
+
+#include <pthread.h>
+#include "rbtree.h"
+
+// back chunks with huge pages, falls back to normal pages
+#define RB_POOL_HUGEPAGE	1
+
+struct rb_pool_chunk;
+
+struct rb_pool {
+	size_t size;			// object size, aligned
+	size_t chunk_size;
+	int flags;
+	struct rb_pool_chunk *chunks;
+	char *next, *end;		// unused space of the newest chunk
+	void *free;			// freed objects, linked through themselves
+	size_t nr_chunks;
+	pthread_mutex_t lock;		// taken by the caches only
+};
+
+// objects moved between a cache and its pool at once
+#define RB_POOL_BATCH	64
+
+struct rb_pool_cache {
+	struct rb_pool *pool;
+	void *free;
+	size_t nr_free;
+};
+
+/*
+ * chunk_size 0 picks 2MB with RB_POOL_HUGEPAGE, 64KB otherwise.
+ * returns -1 if an object does not fit in a chunk.
+ */
+int rb_pool_init(struct rb_pool *pool, size_t size, size_t chunk_size,
+		int flags);
+
+// NULL when out of memory
+void *rb_pool_alloc(struct rb_pool *pool);
+
+void rb_pool_free(struct rb_pool *pool, void *obj);
+
+void rb_pool_cache_init(struct rb_pool_cache *cache, struct rb_pool *pool);
+
+// NULL when out of memory
+void *rb_pool_cache_alloc(struct rb_pool_cache *cache);
+
+void rb_pool_cache_free(struct rb_pool_cache *cache, void *obj);
+
+// give every cached object back to the pool, e.g. when a thread exits
+void rb_pool_cache_flush(struct rb_pool_cache *cache);
+
+/*
+ * release every chunk, the pool can be used again. no thread may use
+ * it meanwhile, and caches must be initialized again afterwards
+ */
+void rb_pool_destroy(struct rb_pool *pool);
+
+// empty tree and free all its nodes, the pool must hold nothing else
+void rb_destroy(struct rb_tree *tree, struct rb_pool *pool);
+
+#endif
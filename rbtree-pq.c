@@ -0,0 +1,50 @@
+/*
+ * priority queue on an rbtree with a cached min
+ */
+
+#include "rbtree-pq.h"
+
+void rb_pq_init(struct rb_pq *pq, int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	rb_init(&pq->tree);
+	pq->min = NULL;
+	pq->cmp = cmp;
+}
+
+void rb_pq_insert(struct rb_pq *pq, struct rb_node *node)
+{
+	rb_insert_multi(&pq->tree, node, pq->cmp);
+
+	// an equal key goes after the min, so only a smaller one replaces it
+	if (!pq->min || pq->cmp(pq->min, node) < 0)
+		pq->min = node;
+}
+
+struct rb_node *rb_pq_pop_min(struct rb_pq *pq)
+{
+	struct rb_node *node = pq->min;
+
+	if (node)
+		pq->min = rb_delete_first(&pq->tree, node);
+	return node;
+}
+
+void rb_pq_delete(struct rb_pq *pq, struct rb_node *node)
+{
+	if (node == pq->min)
+		pq->min = rb_delete_first(&pq->tree, node);
+	else
+		rb_delete(&pq->tree, node);
+}
+
+void rb_pq_decrease_key(struct rb_pq *pq, struct rb_node *node)
+{
+	struct rb_node *prev = rb_prev(node);
+
+	// still not less than its predecessor, the order holds
+	if (!prev || pq->cmp(prev, node) >= 0)
+		return;
+
+	rb_delete(&pq->tree, node);
+	rb_pq_insert(pq, node);
+}
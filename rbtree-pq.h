@@ -0,0 +1,38 @@
+/*
+ * priority queue on an rbtree, the min node is cached so peek is O(1),
+ * pop deletes it with rb_delete_first(). equal keys are allowed and
+ * popped in insertion order. cmp is as for rb_insert()
+ */
+
+#ifndef RBTREE_PQ_H
+#define RBTREE_PQ_H
+
+#include "rbtree.h"
+
+struct rb_pq {
+	struct rb_tree tree;
+	struct rb_node *min;
+	int (*cmp)(struct rb_node *, struct rb_node *);
+};
+
+void rb_pq_init(struct rb_pq *pq, int (*cmp)(struct rb_node *, struct rb_node *));
+
+#define rb_pq_empty(pq) (!(pq)->min)
+
+// the min node without removing it, NULL if empty
+#define rb_pq_peek(pq) ((pq)->min)
+
+void rb_pq_insert(struct rb_pq *pq, struct rb_node *node);
+
+// remove and return the min node, NULL if empty
+struct rb_node *rb_pq_pop_min(struct rb_pq *pq);
+
+void rb_pq_delete(struct rb_pq *pq, struct rb_node *node);
+
+/*
+ * call after lowering the key of node, which is in pq. the node only
+ * moves if it went below its predecessor
+ */
+void rb_pq_decrease_key(struct rb_pq *pq, struct rb_node *node);
+
+#endif
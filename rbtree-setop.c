@@ -0,0 +1,295 @@
+/*
+ * join based set operations on rbtrees
+ *
+ * op(a, b): take the root k of b, split a at k, recurse on the two
+ * halves in parallel, then join the results with k or the node of a
+ * equal to k as the pivot.
+ */
+
+#include <stdlib.h>
+#include "rbtree-setop.h"
+
+enum { UNION, INTERSECT, DIFFERENCE };
+
+struct setop {
+	int kind;
+	int max_depth;		// fork only above this depth
+	int (*cmp)(struct rb_node *, struct rb_node *);
+	void (*drop)(struct rb_node *);
+	struct rb_threads *pool;
+};
+
+struct rb_task {
+	struct rb_task *next;
+	struct setop *op;
+	struct rb_node *a, *b, *result;
+	int depth;
+	int done;
+};
+
+// rb_split() takes a key, the key is the node and the comparator
+struct split_key {
+	struct rb_node *node;
+	int (*cmp)(struct rb_node *, struct rb_node *);
+};
+
+static int key_cmp(struct rb_node *node, const void *key)
+{
+	const struct split_key *k = key;
+
+	return k->cmp(node, k->node);
+}
+
+static struct rb_node *setop(struct setop *op, struct rb_node *a,
+		struct rb_node *b, int depth);
+
+static void run(struct rb_task *task)
+{
+	task->result = setop(task->op, task->a, task->b, task->depth);
+}
+
+static void *worker(void *arg)
+{
+	struct rb_threads *pool = arg;
+	struct rb_task *task;
+
+	pthread_mutex_lock(&pool->lock);
+	while (!pool->stop) {
+		task = pool->queue;
+		if (!task) {
+			pthread_cond_wait(&pool->cond, &pool->lock);
+			continue;
+		}
+		pool->queue = task->next;
+		pthread_mutex_unlock(&pool->lock);
+
+		run(task);
+
+		pthread_mutex_lock(&pool->lock);
+		task->done = 1;
+		pthread_cond_broadcast(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+int rb_threads_init(struct rb_threads *pool, int n)
+{
+	int i;
+
+	pool->queue = NULL;
+	pool->stop = 0;
+	pool->n = 0;
+	pool->tids = calloc(n > 0 ? n : 1, sizeof(pthread_t));
+	if (!pool->tids)
+		return -1;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	for (i = 0; i < n; i++) {
+		if (pthread_create(&pool->tids[i], NULL, worker, pool)) {
+			rb_threads_destroy(pool);
+			return -1;
+		}
+		pool->n++;
+	}
+
+	return 0;
+}
+
+void rb_threads_destroy(struct rb_threads *pool)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->n; i++)
+		pthread_join(pool->tids[i], NULL);
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->cond);
+	free(pool->tids);
+	pool->tids = NULL;
+	pool->n = 0;
+}
+
+static void fork_task(struct rb_threads *pool, struct rb_task *task)
+{
+	task->done = 0;
+	pthread_mutex_lock(&pool->lock);
+	task->next = pool->queue;
+	pool->queue = task;
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+// wait for task, running queued tasks meanwhile, so no thread blocks
+// while there is work, and a task nobody took is run here
+static void join_task(struct rb_threads *pool, struct rb_task *task)
+{
+	struct rb_task *other;
+
+	pthread_mutex_lock(&pool->lock);
+	while (!task->done) {
+		other = pool->queue;
+		if (!other) {
+			pthread_cond_wait(&pool->cond, &pool->lock);
+			continue;
+		}
+		pool->queue = other->next;
+		pthread_mutex_unlock(&pool->lock);
+
+		run(other);
+
+		pthread_mutex_lock(&pool->lock);
+		other->done = 1;
+		pthread_cond_broadcast(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+// hand every node of the subtree to drop
+static void drain(struct setop *op, struct rb_node *root)
+{
+	struct rb_tree tree = { root };
+	struct rb_node *node, *next;
+
+	if (!op->drop)
+		return;
+
+	for (node = rb_first_postorder(&tree); node; node = next) {
+		next = rb_next_postorder(node);
+		op->drop(node);
+	}
+}
+
+static inline void drop(struct setop *op, struct rb_node *node)
+{
+	if (op->drop)
+		op->drop(node);
+}
+
+// make a child a standalone tree, a RED root is painted BLACK
+static inline struct rb_node *detach(struct rb_node *node)
+{
+	if (node)
+		node->parent = RB_BLACK;
+	return node;
+}
+
+static struct rb_node *setop(struct setop *op, struct rb_node *a,
+		struct rb_node *b, int depth)
+{
+	struct rb_tree t1, t2, lo, hi;
+	struct rb_node *l2, *r2, *found, *pivot;
+	struct split_key key;
+	struct rb_task task;
+
+	if (!b) {
+		if (op->kind != INTERSECT)
+			return a;
+		drain(op, a);
+		return NULL;
+	}
+	if (!a) {
+		if (op->kind == UNION)
+			return b;
+		drain(op, b);
+		return NULL;
+	}
+
+	l2 = detach(b->left);
+	r2 = detach(b->right);
+
+	t1.root = a;
+	key.node = b;
+	key.cmp = op->cmp;
+	found = rb_split(&t1, &key, key_cmp, &lo, &hi);
+
+	task.op = op;
+	task.a = lo.root;
+	task.b = l2;
+	task.depth = depth + 1;
+
+	if (op->pool && depth < op->max_depth) {
+		fork_task(op->pool, &task);
+		t2.root = setop(op, hi.root, r2, depth + 1);
+		join_task(op->pool, &task);
+	}
+	else {
+		run(&task);
+		t2.root = setop(op, hi.root, r2, depth + 1);
+	}
+	t1.root = task.result;
+
+	switch (op->kind) {
+	case UNION:
+		if (found) {
+			drop(op, b);
+			pivot = found;
+		}
+		else
+			pivot = b;
+		break;
+	case INTERSECT:
+		drop(op, b);
+		pivot = found;
+		break;
+	default:
+		drop(op, b);
+		if (found)
+			drop(op, found);
+		pivot = NULL;
+		break;
+	}
+
+	rb_join(&t1, pivot, &t2);
+	return t1.root;
+}
+
+static void run_setop(int kind, struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool)
+{
+	struct setop op;
+	int n;
+
+	op.kind = kind;
+	op.cmp = cmp;
+	op.drop = drop;
+	op.pool = pool && pool->n ? pool : NULL;
+
+	// a few tasks per thread to balance uneven halves
+	op.max_depth = 3;
+	for (n = op.pool ? op.pool->n + 1 : 1; n > 1; n >>= 1)
+		op.max_depth++;
+
+	t1->root = setop(&op, t1->root, t2->root, 0);
+	t2->root = NULL;
+}
+
+void rb_union(struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool)
+{
+	run_setop(UNION, t1, t2, cmp, drop, pool);
+}
+
+void rb_intersect(struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool)
+{
+	run_setop(INTERSECT, t1, t2, cmp, drop, pool);
+}
+
+void rb_difference(struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool)
+{
+	run_setop(DIFFERENCE, t1, t2, cmp, drop, pool);
+}
@@ -0,0 +1,50 @@
+/*
+ * join based set operations on rbtrees, union, intersection and
+ * difference, with the two halves of each step run in parallel on a
+ * small fork-join thread pool
+ */
+
+#ifndef RBTREE_SETOP_H
+#define RBTREE_SETOP_H
+
+#include <pthread.h>
+#include "rbtree.h"
+
+struct rb_task;
+
+struct rb_threads {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct rb_task *queue;
+	pthread_t *tids;
+	int n;
+	int stop;
+};
+
+// start n worker threads, the calling thread works too
+int rb_threads_init(struct rb_threads *pool, int n);
+
+void rb_threads_destroy(struct rb_threads *pool);
+
+/*
+ * the result is left in t1 and t2 is emptied. nodes not in the result
+ * are passed to drop, if not NULL. drop may be called from any thread
+ * of the pool. pool may be NULL to run in the calling thread only.
+ *
+ * union keeps the node of t1 when both trees have the key.
+ * intersect keeps the nodes of t1 whose key is in t2.
+ * difference keeps the nodes of t1 whose key is not in t2.
+ */
+void rb_union(struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool);
+
+void rb_intersect(struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool);
+
+void rb_difference(struct rb_tree *t1, struct rb_tree *t2,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		void (*drop)(struct rb_node *), struct rb_threads *pool);
+
+#endif
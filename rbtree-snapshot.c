@@ -0,0 +1,234 @@
+/*
+ * static B+ tree snapshot
+ *
+ * level 0 is the sorted keys, padded to whole blocks with UINT64_MAX.
+ * key j of block b on level l > 0 is the largest key below block
+ * 8b + j of level l - 1, UINT64_MAX past the last block. the lower
+ * bound of x is in the first child whose largest key is >= x, that is
+ * child number "count of keys < x" in the block. keys above the largest
+ * are handled before the descent, so it never enters padding.
+ *
+ * keys are stored with the top bit flipped: x86 only has signed 64 bit
+ * compares, and flipping it maps unsigned order onto signed order. the
+ * rank of x in a block is then the popcount of one compare mask.
+ */
+
+#include <stdlib.h>
+#include "rbtree-snapshot.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86
+#endif
+
+#define B	RB_SNAPSHOT_B
+#define BIAS	(1ULL << 63)
+#define PAD	(UINT64_MAX ^ BIAS)
+
+static inline size_t div_up(size_t a, size_t b)
+{
+	return (a + b - 1) / b;
+}
+
+int rb_snapshot_build(struct rb_snapshot *snap, struct rb_tree *tree,
+		uint64_t (*key)(struct rb_node *))
+{
+	size_t nblocks[RB_SNAPSHOT_MAX_LEVELS];
+	size_t n = 0, total = 0, span, i, b, last;
+	struct rb_node *node;
+	uint64_t *keys, *blk;
+	int l, levels;
+
+	rb_for_each(node, tree)
+		n++;
+
+	snap->n = n;
+	snap->levels = 0;
+	snap->blocks = NULL;
+	snap->nodes = NULL;
+	snap->max = 0;
+	if (rb_snapshot_use(snap, RB_SNAPSHOT_AVX2) &&
+			rb_snapshot_use(snap, RB_SNAPSHOT_SSE42))
+		rb_snapshot_use(snap, RB_SNAPSHOT_SCALAR);
+	if (!n)
+		return 0;
+
+	// blocks per level, bottom up until a single root block
+	levels = 0;
+	span = 1;
+	do {
+		nblocks[levels] = div_up(div_up(n, B), span);
+		total += nblocks[levels];
+		levels++;
+		span *= B;
+	} while (nblocks[levels - 1] > 1);
+
+	// root level first in memory
+	for (l = levels - 1, b = 0; l >= 0; l--) {
+		snap->level[l] = b;
+		b += nblocks[l];
+	}
+
+	snap->nodes = malloc(n * sizeof(*snap->nodes));
+	if (!snap->nodes ||
+			posix_memalign((void **)&snap->blocks, 64,
+				total * B * sizeof(uint64_t))) {
+		free(snap->nodes);
+		snap->nodes = NULL;
+		snap->blocks = NULL;
+		return -1;
+	}
+	snap->levels = levels;
+
+	keys = snap->blocks + snap->level[0] * B;
+	i = 0;
+	rb_for_each(node, tree) {
+		snap->nodes[i] = node;
+		keys[i++] = key(node) ^ BIAS;
+	}
+	for (; i < nblocks[0] * B; i++)
+		keys[i] = PAD;
+	snap->max = keys[n - 1] ^ BIAS;
+
+	// entry j of block b on level l covers keys below (8b + j + 1) * 8^l
+	for (l = 1, span = B; l < levels; l++, span *= B) {
+		blk = snap->blocks + snap->level[l] * B;
+		for (i = 0; i < nblocks[l] * B; i++) {
+			if (i >= nblocks[l - 1]) {
+				blk[i] = PAD;
+				continue;
+			}
+			last = (i + 1) * span - 1;
+			blk[i] = keys[last < n ? last : n - 1];
+		}
+	}
+
+	return 0;
+}
+
+void rb_snapshot_destroy(struct rb_snapshot *snap)
+{
+	free(snap->blocks);
+	free(snap->nodes);
+	snap->blocks = NULL;
+	snap->nodes = NULL;
+	snap->n = 0;
+	snap->levels = 0;
+}
+
+/*
+ * number of keys < x in a block, x is biased. the descent is expanded
+ * once per block search so the compiler inlines each of them.
+ */
+static inline unsigned int rank_scalar(const uint64_t *blk, uint64_t x)
+{
+	unsigned int i, r = 0;
+
+	for (i = 0; i < B; i++)
+		r += (int64_t)blk[i] < (int64_t)x;
+	return r;
+}
+
+#define DEFINE_SEARCH(name, rank)					\
+static size_t name(const struct rb_snapshot *snap, uint64_t x)		\
+{									\
+	size_t b = 0;							\
+	int l;								\
+									\
+	for (l = snap->levels - 1; l > 0; l--)				\
+		b = b * B + rank(snap->blocks + (snap->level[l] + b) * B, x); \
+									\
+	return b * B + rank(snap->blocks + (snap->level[0] + b) * B, x); \
+}
+
+DEFINE_SEARCH(search_scalar, rank_scalar)
+
+#ifdef HAVE_X86
+__attribute__((target("sse4.2,popcnt")))
+static inline unsigned int rank_sse42(const uint64_t *blk, uint64_t x)
+{
+	__m128i v = _mm_set1_epi64x(x);
+	unsigned int mask = 0, i;
+
+	for (i = 0; i < B; i += 2) {
+		__m128i k = _mm_load_si128((const __m128i *)(blk + i));
+		__m128i lt = _mm_cmpgt_epi64(v, k);
+
+		mask |= _mm_movemask_pd(_mm_castsi128_pd(lt)) << i;
+	}
+	return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2,popcnt")))
+static inline unsigned int rank_avx2(const uint64_t *blk, uint64_t x)
+{
+	__m256i v = _mm256_set1_epi64x(x);
+	__m256i lo = _mm256_cmpgt_epi64(v,
+			_mm256_load_si256((const __m256i *)blk));
+	__m256i hi = _mm256_cmpgt_epi64(v,
+			_mm256_load_si256((const __m256i *)(blk + 4)));
+	unsigned int mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo)) |
+		_mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4;
+
+	return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse4.2,popcnt")))
+DEFINE_SEARCH(search_sse42, rank_sse42)
+
+__attribute__((target("avx2,popcnt")))
+DEFINE_SEARCH(search_avx2, rank_avx2)
+#endif
+
+int rb_snapshot_use(struct rb_snapshot *snap, int isa)
+{
+	switch (isa) {
+	case RB_SNAPSHOT_SCALAR:
+		snap->search = search_scalar;
+		return 0;
+#ifdef HAVE_X86
+	case RB_SNAPSHOT_SSE42:
+		if (!__builtin_cpu_supports("sse4.2") ||
+				!__builtin_cpu_supports("popcnt"))
+			return -1;
+		snap->search = search_sse42;
+		return 0;
+	case RB_SNAPSHOT_AVX2:
+		if (!__builtin_cpu_supports("avx2") ||
+				!__builtin_cpu_supports("popcnt"))
+			return -1;
+		snap->search = search_avx2;
+		return 0;
+#endif
+	default:
+		return -1;
+	}
+}
+
+size_t rb_snapshot_lower_bound(const struct rb_snapshot *snap, uint64_t key)
+{
+	if (!snap->n || key > snap->max)
+		return snap->n;
+	return snap->search(snap, key ^ BIAS);
+}
+
+struct rb_node *rb_snapshot_find(const struct rb_snapshot *snap, uint64_t key)
+{
+	size_t i = rb_snapshot_lower_bound(snap, key);
+
+	if (i < snap->n && snap->blocks[snap->level[0] * B + i] == (key ^ BIAS))
+		return snap->nodes[i];
+	return NULL;
+}
+
+struct rb_node *rb_snapshot_next_from(const struct rb_snapshot *snap,
+		uint64_t key)
+{
+	size_t i;
+
+	if (key == UINT64_MAX)
+		return NULL;
+
+	i = rb_snapshot_lower_bound(snap, key + 1);
+	return i < snap->n ? snap->nodes[i] : NULL;
+}
@@ -0,0 +1,66 @@
+/*
+ * read only snapshot of an rbtree, laid out as a static B+ tree
+ *
+ * the keys of the tree, given by a uint64_t key function, are copied
+ * into 64 byte blocks of 8 keys. the bottom level is the sorted keys,
+ * each upper level holds the largest key of each block below, so a
+ * lookup reads one cache line per level, 8 levels for 10M keys instead
+ * of about 25 for the tree. the snapshot does not follow later changes
+ * to the tree, rebuild it.
+ *
+ * blocks are searched with AVX2 or SSE4.2 compares when the cpu has
+ * them. for int64_t keys, have the key function return
+ * key ^ (1ULL << 63) so they sort as unsigned.
+ */
+
+#ifndef RBTREE_SNAPSHOT_H
+#define RBTREE_SNAPSHOT_H
+
+#include <stdint.h>
+#include "rbtree.h"
+
+#define RB_SNAPSHOT_B		8
+#define RB_SNAPSHOT_MAX_LEVELS	22	// 8^22 > 2^64
+
+enum {
+	RB_SNAPSHOT_SCALAR,
+	RB_SNAPSHOT_SSE42,
+	RB_SNAPSHOT_AVX2,
+};
+
+struct rb_snapshot {
+	size_t n;
+	int levels;
+	// all levels, the root block first, stored as key ^ 1 << 63 so
+	// signed 64 bit compares order them
+	uint64_t *blocks;
+	size_t level[RB_SNAPSHOT_MAX_LEVELS];	// first block of each level
+	struct rb_node **nodes;		// nodes in key order
+	uint64_t max;
+	size_t (*search)(const struct rb_snapshot *, uint64_t);
+};
+
+// returns -1 when out of memory
+int rb_snapshot_build(struct rb_snapshot *snap, struct rb_tree *tree,
+		uint64_t (*key)(struct rb_node *));
+
+void rb_snapshot_destroy(struct rb_snapshot *snap);
+
+/*
+ * search blocks with the given instructions instead of the best the
+ * cpu has, returns -1 if it lacks them
+ */
+int rb_snapshot_use(struct rb_snapshot *snap, int isa);
+
+// index in snap->nodes of the first key >= key, snap->n if none
+size_t rb_snapshot_lower_bound(const struct rb_snapshot *snap, uint64_t key);
+
+// node with key, NULL if none
+struct rb_node *rb_snapshot_find(const struct rb_snapshot *snap,
+		uint64_t key);
+
+// first node greater than key, like rb_next_from()
+struct rb_node *rb_snapshot_next_from(const struct rb_snapshot *snap,
+		uint64_t key);
+
+#endif
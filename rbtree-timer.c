@@ -0,0 +1,237 @@
+/*
+ * timers over an rbtree priority queue, with far timers kept out of it
+ */
+
+#include <limits.h>
+#include "rbtree-timer.h"
+
+#define WHEEL_MASK	(RB_TIMER_WHEEL_SIZE - 1)
+
+#define T(n) rb_entry(n, struct rb_timer, node)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (T(r)->expires != T(l)->expires)
+		return T(r)->expires < T(l)->expires ? -1 : 1;
+	return 0;
+}
+
+void rb_timer_base_init(struct rb_timer_base *base, unsigned long now,
+		unsigned int shift)
+{
+	int i;
+
+	rb_pq_init(&base->near, cmp);
+	base->slot = now >> shift;
+	base->shift = shift;
+	base->bitmap = 0;
+	for (i = 0; i < RB_TIMER_WHEEL_SIZE; i++)
+		base->wheel[i] = NULL;
+	base->overflow = NULL;
+	base->count = 0;
+}
+
+void rb_timer_init(struct rb_timer *timer, void (*fn)(struct rb_timer *))
+{
+	timer->fn = fn;
+	timer->state = RB_TIMER_IDLE;
+}
+
+static inline void list_add(struct rb_timer **head, struct rb_timer *timer)
+{
+	timer->next = *head;
+	if (*head)
+		(*head)->pprev = &timer->next;
+	timer->pprev = head;
+	*head = timer;
+}
+
+static inline void list_del(struct rb_timer *timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next)
+		timer->next->pprev = timer->pprev;
+}
+
+// the tree for the current slot and before, a bucket for the next 63
+static void place(struct rb_timer_base *base, struct rb_timer *timer)
+{
+	unsigned long slot = timer->expires >> base->shift;
+	unsigned int i;
+
+	if (slot <= base->slot) {
+		timer->state = RB_TIMER_NEAR;
+		rb_pq_insert(&base->near, &timer->node);
+	} else if (slot - base->slot < RB_TIMER_WHEEL_SIZE) {
+		i = slot & WHEEL_MASK;
+		timer->state = RB_TIMER_FAR;
+		list_add(&base->wheel[i], timer);
+		base->bitmap |= 1ULL << i;
+	} else {
+		timer->state = RB_TIMER_OVERFLOW;
+		list_add(&base->overflow, timer);
+	}
+}
+
+static void unlink_timer(struct rb_timer_base *base, struct rb_timer *timer)
+{
+	unsigned int i;
+
+	if (timer->state == RB_TIMER_NEAR) {
+		rb_pq_delete(&base->near, &timer->node);
+		return;
+	}
+
+	list_del(timer);
+	if (timer->state == RB_TIMER_FAR) {
+		i = (timer->expires >> base->shift) & WHEEL_MASK;
+		if (!base->wheel[i])
+			base->bitmap &= ~(1ULL << i);
+	}
+}
+
+void rb_timer_arm(struct rb_timer_base *base, struct rb_timer *timer,
+		unsigned long expires)
+{
+	unsigned long slot = expires >> base->shift;
+
+	if (timer->state == RB_TIMER_IDLE) {
+		base->count++;
+	} else {
+		// still the same bucket, or still beyond the wheel
+		if (timer->state == RB_TIMER_FAR &&
+				slot == timer->expires >> base->shift) {
+			timer->expires = expires;
+			return;
+		}
+		if (timer->state == RB_TIMER_OVERFLOW &&
+				slot - base->slot >= RB_TIMER_WHEEL_SIZE &&
+				slot > base->slot) {
+			timer->expires = expires;
+			return;
+		}
+		unlink_timer(base, timer);
+	}
+
+	timer->expires = expires;
+	place(base, timer);
+}
+
+int rb_timer_cancel(struct rb_timer_base *base, struct rb_timer *timer)
+{
+	if (timer->state == RB_TIMER_IDLE)
+		return 0;
+
+	unlink_timer(base, timer);
+	timer->state = RB_TIMER_IDLE;
+	base->count--;
+	return 1;
+}
+
+// first slot after the current one with a bucket, 0 if none
+static inline unsigned long next_bucket(struct rb_timer_base *base)
+{
+	unsigned int i = (base->slot + 1) & WHEEL_MASK;
+	uint64_t bits = base->bitmap;
+
+	if (!bits)
+		return 0;
+	if (i)
+		bits = bits >> i | bits << (RB_TIMER_WHEEL_SIZE - i);
+	return base->slot + 1 + __builtin_ctzll(bits);
+}
+
+unsigned long rb_timer_next(struct rb_timer_base *base)
+{
+	struct rb_node *node = rb_pq_peek(&base->near);
+	unsigned long slot, round;
+
+	if (node)
+		return T(node)->expires;
+
+	// overflow timers are not before the next round of the wheel
+	slot = next_bucket(base);
+	round = (base->slot | WHEEL_MASK) + 1;
+	if (base->overflow && (!slot || round < slot))
+		slot = round;
+	return slot ? slot << base->shift : ULONG_MAX;
+}
+
+/*
+ * move on to the next slot with work before target, or to target. the
+ * tree is empty here, everything in it was due
+ */
+static void advance(struct rb_timer_base *base, unsigned long target)
+{
+	unsigned long round = (base->slot | WHEEL_MASK) + 1;
+	unsigned long slot = next_bucket(base);
+	struct rb_timer *timer, *next;
+	unsigned int i;
+
+	if (!slot || slot > round)
+		slot = round;
+	if (slot > target) {
+		base->slot = target;
+		return;
+	}
+	base->slot = slot;
+
+	// a new round of the wheel, pull in the overflow timers now in reach
+	if (slot == round) {
+		for (timer = base->overflow; timer; timer = next) {
+			next = timer->next;
+			if ((timer->expires >> base->shift) - slot <
+					RB_TIMER_WHEEL_SIZE) {
+				list_del(timer);
+				place(base, timer);
+			}
+		}
+	}
+
+	i = slot & WHEEL_MASK;
+	for (timer = base->wheel[i]; timer; timer = next) {
+		next = timer->next;
+		timer->state = RB_TIMER_NEAR;
+		rb_pq_insert(&base->near, &timer->node);
+	}
+	base->wheel[i] = NULL;
+	base->bitmap &= ~(1ULL << i);
+}
+
+static size_t run(struct rb_timer_base *base, unsigned long now,
+		struct rb_timer **out, size_t max)
+{
+	unsigned long target = now >> base->shift;
+	struct rb_node *node;
+	struct rb_timer *timer;
+	size_t n = 0;
+
+	for (;;) {
+		while (n < max && (node = rb_pq_peek(&base->near)) &&
+				T(node)->expires <= now) {
+			rb_pq_pop_min(&base->near);
+			timer = T(node);
+			timer->state = RB_TIMER_IDLE;
+			base->count--;
+			if (out)
+				out[n] = timer;
+			else
+				timer->fn(timer);
+			n++;
+		}
+		if (n == max || base->slot >= target)
+			return n;
+		advance(base, target);
+	}
+}
+
+size_t rb_timer_expire(struct rb_timer_base *base, unsigned long now)
+{
+	return run(base, now, NULL, SIZE_MAX);
+}
+
+size_t rb_timer_expire_batch(struct rb_timer_base *base, unsigned long now,
+		struct rb_timer **out, size_t max)
+{
+	return run(base, now, out, max);
+}
@@ -0,0 +1,89 @@
+/*
+ * timers over an rbtree priority queue, with far timers kept out of it
+ *
+ * time is cut into slots of 1 << shift ticks. only timers due in the
+ * current slot, or overdue, are in the tree (an rb_pq). timers due in
+ * the next 63 slots wait in a wheel of 64 unsorted buckets, one per
+ * slot, and later ones in an overflow list. arming, rearming and
+ * cancelling a far timer is a list operation, the tree is not touched.
+ * a bucket enters the tree when time reaches its slot, the overflow
+ * list is redistributed every 64 slots.
+ */
+
+#ifndef RBTREE_TIMER_H
+#define RBTREE_TIMER_H
+
+#include <stdint.h>
+#include "rbtree-pq.h"
+
+#define RB_TIMER_WHEEL_SIZE	64
+
+struct rb_timer {
+	union {
+		struct rb_node node;		// in the tree
+		struct {			// in a bucket or overflow
+			struct rb_timer *next;
+			struct rb_timer **pprev;
+		};
+	};
+	unsigned long expires;
+	void (*fn)(struct rb_timer *);
+	int state;
+};
+
+enum {
+	RB_TIMER_IDLE,
+	RB_TIMER_NEAR,
+	RB_TIMER_FAR,
+	RB_TIMER_OVERFLOW,
+};
+
+struct rb_timer_base {
+	struct rb_pq near;
+	unsigned long slot;		// current slot, time >> shift
+	unsigned int shift;
+	uint64_t bitmap;		// non empty buckets
+	struct rb_timer *wheel[RB_TIMER_WHEEL_SIZE];
+	struct rb_timer *overflow;
+	size_t count;			// pending timers
+};
+
+// now is the current time, slots are 1 << shift ticks
+void rb_timer_base_init(struct rb_timer_base *base, unsigned long now,
+		unsigned int shift);
+
+// fn is called when the timer expires, it may rearm the timer
+void rb_timer_init(struct rb_timer *timer, void (*fn)(struct rb_timer *));
+
+#define rb_timer_pending(timer) ((timer)->state != RB_TIMER_IDLE)
+
+// arm timer to expire at expires, a pending timer is moved
+void rb_timer_arm(struct rb_timer_base *base, struct rb_timer *timer,
+		unsigned long expires);
+
+// returns 1 if the timer was pending
+int rb_timer_cancel(struct rb_timer_base *base, struct rb_timer *timer);
+
+/*
+ * the earliest expiry in O(1), ULONG_MAX if nothing is pending. it is
+ * exact when a timer is due in the current slot, otherwise it is the
+ * start of the next slot holding timers, a time to wake up and call
+ * rb_timer_expire() at
+ */
+unsigned long rb_timer_next(struct rb_timer_base *base);
+
+/*
+ * advance the time to now and call fn of every timer expiring at or
+ * before now, in expiry order. returns the number of timers expired
+ */
+size_t rb_timer_expire(struct rb_timer_base *base, unsigned long now);
+
+/*
+ * same as rb_timer_expire(), but the expired timers are stored in out
+ * instead of calling fn, at most max of them. call again while it
+ * returns max
+ */
+size_t rb_timer_expire_batch(struct rb_timer_base *base, unsigned long now,
+		struct rb_timer **out, size_t max);
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * top down red black trees
+ *
+ * both operations descend from a false root above the real root, so
+ * the root needs no special case. insert splits nodes with two red
+ * children on the way down and fixes a red violation at once with a
+ * rotation at the grandparent. delete pushes a red node down ahead of
+ * the search, so the node finally removed is red. dir 0 is left, 1 is
+ * right.
+ */
+
+#include "rbtree-topdown.h"
+
+#define LEFT(n)	rb_td_left(n)
+
+static inline struct rb_tdnode *child(struct rb_tdnode *n, int dir)
+{
+	return dir ? n->right : LEFT(n);
+}
+
+static inline void set_child(struct rb_tdnode *n, int dir, struct rb_tdnode *c)
+{
+	if (dir)
+		n->right = c;
+	else
+		n->left = (uintptr_t)c | (n->left & 1);
+}
+
+static inline void set_color(struct rb_tdnode *n, int color)
+{
+	n->left = (n->left & ~(uintptr_t)1) | color;
+}
+
+// NULL is BLACK
+static inline int is_red(struct rb_tdnode *n)
+{
+	return n && (n->left & 1) == RB_RED;
+}
+
+// rotate root towards dir, returns the new subtree root
+static struct rb_tdnode *single(struct rb_tdnode *root, int dir)
+{
+	struct rb_tdnode *save = child(root, !dir);
+
+	set_child(root, !dir, child(save, dir));
+	set_child(save, dir, root);
+	set_color(root, RB_RED);
+	set_color(save, RB_BLACK);
+	return save;
+}
+
+static struct rb_tdnode *twice(struct rb_tdnode *root, int dir)
+{
+	set_child(root, !dir, single(child(root, !dir), !dir));
+	return single(root, dir);
+}
+
+struct rb_tdnode *rb_td_find(struct rb_tdtree *tree, const void *key,
+		int (*cmp)(struct rb_tdnode *, const void *))
+{
+	struct rb_tdnode *node = tree->root;
+	int ret;
+
+	while (node) {
+		ret = cmp(node, key);
+		if (ret < 0)
+			node = LEFT(node);
+		else if (ret > 0)
+			node = node->right;
+		else
+			return node;
+	}
+
+	return NULL;
+}
+
+int rb_td_insert(struct rb_tdtree *tree, struct rb_tdnode *node,
+		int (*cmp)(struct rb_tdnode *, struct rb_tdnode *))
+{
+	struct rb_tdnode head = { 0, NULL };
+	struct rb_tdnode *g, *t, *p, *q;
+	int dir = 0, last = 0, dir2, ret, inserted = 0;
+
+	node->left = RB_RED;
+	node->right = NULL;
+
+	if (!tree->root) {
+		set_color(node, RB_BLACK);
+		tree->root = node;
+		return 1;
+	}
+
+	// t is the great grandparent, above g, p and q
+	t = &head;
+	g = p = NULL;
+	q = tree->root;
+	t->right = q;
+
+	for (;;) {
+		if (!q) {
+			q = node;
+			set_child(p, dir, q);
+			inserted = 1;
+		}
+		else if (is_red(LEFT(q)) && is_red(q->right)) {
+			// split a 4-node
+			set_color(q, RB_RED);
+			set_color(LEFT(q), RB_BLACK);
+			set_color(q->right, RB_BLACK);
+		}
+
+		// two reds in a row
+		if (is_red(q) && is_red(p)) {
+			dir2 = t->right == g;
+			if (q == child(p, last))
+				set_child(t, dir2, single(g, !last));
+			else
+				set_child(t, dir2, twice(g, !last));
+		}
+
+		if (inserted)
+			break;
+		ret = cmp(q, node);
+		if (!ret)
+			break;
+
+		last = dir;
+		dir = ret > 0;
+		if (g)
+			t = g;
+		g = p;
+		p = q;
+		q = child(q, dir);
+	}
+
+	tree->root = head.right;
+	set_color(tree->root, RB_BLACK);
+	return inserted;
+}
+
+struct rb_tdnode *rb_td_delete(struct rb_tdtree *tree, const void *key,
+		int (*cmp)(struct rb_tdnode *, const void *))
+{
+	struct rb_tdnode head = { 0, NULL };
+	struct rb_tdnode *q, *p, *g, *s, *f = NULL, *fp = NULL;
+	int dir = 1, last, dir2, ret;
+
+	if (!tree->root)
+		return NULL;
+
+	// q walks down to the predecessor of the node found, f
+	q = &head;
+	g = p = NULL;
+	q->right = tree->root;
+
+	while (child(q, dir)) {
+		last = dir;
+		g = p;
+		p = q;
+		q = child(q, dir);
+		ret = cmp(q, key);
+		dir = ret > 0;
+		if (!ret)
+			f = q;
+
+		// push a red node down
+		if (!is_red(q) && !is_red(child(q, dir))) {
+			if (is_red(child(q, !dir))) {
+				set_child(p, last, single(q, dir));
+				p = child(p, last);
+			}
+			else if ((s = child(p, !last))) {
+				if (!is_red(LEFT(s)) && !is_red(s->right)) {
+					// color flip
+					set_color(p, RB_BLACK);
+					set_color(s, RB_RED);
+					set_color(q, RB_RED);
+				}
+				else {
+					dir2 = g->right == p;
+					if (is_red(child(s, last)))
+						set_child(g, dir2, twice(p, last));
+					else
+						set_child(g, dir2, single(p, last));
+
+					s = child(g, dir2);
+					set_color(q, RB_RED);
+					set_color(s, RB_RED);
+					set_color(LEFT(s), RB_BLACK);
+					set_color(s->right, RB_BLACK);
+
+					// p went down below s
+					if (p == f)
+						fp = s;
+				}
+			}
+		}
+
+		if (q == f)
+			fp = p;
+	}
+
+	if (f) {
+		// q has at most one child, unlink it
+		set_child(p, p->right == q, child(q, !LEFT(q)));
+
+		// and put it in the place of f
+		if (q != f) {
+			q->left = f->left;
+			q->right = f->right;
+			set_child(fp, fp->right == f, q);
+		}
+	}
+
+	tree->root = head.right;
+	if (tree->root)
+		set_color(tree->root, RB_BLACK);
+	return f;
+}
+
+static inline void push_left(struct rb_td_iter *iter, struct rb_tdnode *node)
+{
+	for (; node; node = LEFT(node))
+		iter->stack[iter->depth++] = node;
+}
+
+struct rb_tdnode *rb_td_iter_first(struct rb_td_iter *iter,
+		struct rb_tdtree *tree)
+{
+	iter->depth = 0;
+	push_left(iter, tree->root);
+	return iter->depth ? iter->stack[iter->depth - 1] : NULL;
+}
+
+struct rb_tdnode *rb_td_iter_next(struct rb_td_iter *iter)
+{
+	struct rb_tdnode *node = iter->stack[--iter->depth];
+
+	push_left(iter, node->right);
+	return iter->depth ? iter->stack[iter->depth - 1] : NULL;
+}
@@ -0,0 +1,65 @@
+/*
+ * rbtree without parent links, rebalanced top down
+ *
+ * a node is a left and a right link, 16 bytes, the color is the low bit
+ * of the left link. insert and delete fix the tree on the way down in a
+ * single pass (Julienne Walker's top down algorithms), so no path has
+ * to be walked back up. delete works by key. iteration keeps the path
+ * on an explicit stack.
+ */
+
+#ifndef RBTREE_TOPDOWN_H
+#define RBTREE_TOPDOWN_H
+
+#include <stdint.h>
+#include "rbtree.h"
+
+struct rb_tdnode {
+	uintptr_t left;			// left child | color
+	struct rb_tdnode *right;
+};
+
+struct rb_tdtree {
+	struct rb_tdnode *root;
+};
+
+// a red black tree of 2^48 nodes is at most 96 deep
+#define RB_TD_MAX_DEPTH	96
+
+struct rb_td_iter {
+	struct rb_tdnode *stack[RB_TD_MAX_DEPTH];
+	int depth;
+};
+
+static inline void rb_td_init(struct rb_tdtree *tree)
+{
+	tree->root = NULL;
+}
+
+static inline struct rb_tdnode *rb_td_left(const struct rb_tdnode *node)
+{
+	return (struct rb_tdnode *)(node->left & ~(uintptr_t)1);
+}
+
+// cmp(node, key) < 0 if key sorts before node, like rb_find()
+struct rb_tdnode *rb_td_find(struct rb_tdtree *tree, const void *key,
+		int (*cmp)(struct rb_tdnode *, const void *));
+
+// returns 0 if a node with the same key is in the tree
+int rb_td_insert(struct rb_tdtree *tree, struct rb_tdnode *node,
+		int (*cmp)(struct rb_tdnode *, struct rb_tdnode *));
+
+// unlink and return the node with key, NULL if there is none
+struct rb_tdnode *rb_td_delete(struct rb_tdtree *tree, const void *key,
+		int (*cmp)(struct rb_tdnode *, const void *));
+
+struct rb_tdnode *rb_td_iter_first(struct rb_td_iter *iter,
+		struct rb_tdtree *tree);
+
+struct rb_tdnode *rb_td_iter_next(struct rb_td_iter *iter);
+
+#define rb_td_for_each(node, iter, tree) \
+	for (node = rb_td_iter_first(iter, tree); node; \
+			node = rb_td_iter_next(iter))
+
+#endif
@@ -1,6 +1,20 @@
 #include "rbtree.h"
 #include <stddef.h>
 
+/*
+ * lockless readers (rbtree-concurrent.c) follow the child links while
+ * they are rewritten. built with RB_CONCURRENT, links are stored in one
+ * piece, and a new node is published with release order so its fields
+ * are seen before it. other trees get plain stores
+ */
+#ifdef RB_CONCURRENT
+#define WRITE_LINK(link, node) __atomic_store_n(&(link), (node), __ATOMIC_RELAXED)
+#define PUBLISH_LINK(link, node) __atomic_store_n(&(link), (node), __ATOMIC_RELEASE)
+#else
+#define WRITE_LINK(link, node) ((link) = (node))
+#define PUBLISH_LINK(link, node) ((link) = (node))
+#endif
+
 static inline void rb_set_parent(struct rb_node *node, struct rb_node *parent)
 {
 	node->parent = rb_color(node) + (unsigned long)parent;
@@ -68,6 +82,53 @@ struct rb_node *rb_next_from(struct rb_tree *tree, const void *key,
 	return want;
 }
 
+// last is right most node
+struct rb_node *rb_last(struct rb_tree *tree)
+{
+	struct rb_node *node = tree->root;
+	if (!node)
+		return NULL;
+	while (node->right)
+		node = node->right;
+	return node;
+}
+
+struct rb_node *rb_prev(struct rb_node *node)
+{
+	struct rb_node *parent;
+
+	if (node->left) {
+		node = node->left;
+		while (node->right)
+			node = node->right;
+		return node;
+	}
+
+	while ((parent = rb_parent(node)) && node == parent->left)
+		node = parent;
+
+	return parent;
+}
+
+struct rb_node *rb_prev_from(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	struct rb_node *node = tree->root, *want = NULL;
+	int ret;
+
+	while (node) {
+		ret = cmp(node, key);
+		if (ret > 0) {
+			want = node;
+			node = node->right;
+		} else {
+			node = node->left;
+		}
+	}
+
+	return want;
+}
+
 // post order: left first, right next, self last
 static struct rb_node *rb_left_deepest_node(struct rb_node *node)
 {
@@ -106,6 +167,95 @@ struct rb_node *rb_first_postorder(struct rb_tree *tree)
 	return rb_left_deepest_node(node);
 }
 
+struct rb_node *rb_lower_bound(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	struct rb_node *node = tree->root, *want = NULL;
+
+	while (node) {
+		if (cmp(node, key) <= 0) {
+			want = node;
+			node = node->left;
+		} else {
+			node = node->right;
+		}
+	}
+
+	return want;
+}
+
+struct rb_node *rb_floor(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	struct rb_node *node = tree->root, *want = NULL;
+	int ret;
+
+	while (node) {
+		ret = cmp(node, key);
+		if (ret < 0) {
+			node = node->left;
+		} else {
+			// keep right past equal nodes, to the last of a run
+			want = node;
+			node = node->right;
+		}
+	}
+
+	return want;
+}
+
+struct rb_node *rb_find_or_insert_pos(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_node **parent, struct rb_node ***link)
+{
+	struct rb_node **tmp = &tree->root;
+	struct rb_node *p = NULL;
+	int ret;
+
+	while (*tmp) {
+		p = *tmp;
+		ret = cmp(p, key);
+		if (ret < 0)
+			tmp = &p->left;
+		else if (ret > 0)
+			tmp = &p->right;
+		else
+			return p;
+	}
+
+	*parent = p;
+	*link = tmp;
+	return NULL;
+}
+
+static struct rb_node *range_step(struct rb_range_iter *iter)
+{
+	struct rb_node *node = iter->next, *next;
+
+	if (node) {
+		next = rb_next(node);
+		iter->next = next && iter->cmp(next, iter->hi) > 0 ? next : NULL;
+	}
+	return node;
+}
+
+struct rb_node *rb_range_first(struct rb_range_iter *iter,
+		struct rb_tree *tree, const void *lo, const void *hi,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	struct rb_node *node = rb_lower_bound(tree, lo, cmp);
+
+	iter->hi = hi;
+	iter->cmp = cmp;
+	iter->next = node && cmp(node, hi) > 0 ? node : NULL;
+	return range_step(iter);
+}
+
+struct rb_node *rb_range_next(struct rb_range_iter *iter)
+{
+	return range_step(iter);
+}
+
 struct rb_node *rb_find(struct rb_tree *tree, const void *key,
 		int (*cmp)(struct rb_node *, const void *))
 {
@@ -125,86 +275,97 @@ struct rb_node *rb_find(struct rb_tree *tree, const void *key,
 	return NULL;
 }
 
-static inline void replace(struct rb_tree *tree, struct rb_node *old, struct rb_node *new)
+// descents in flight in rb_find_batch(), enough to cover a miss
+#define FIND_BATCH 16
+
+void rb_find_batch(struct rb_tree *tree, const void *const keys[], size_t n,
+		int (*cmp)(struct rb_node *, const void *), struct rb_node *out[])
 {
-	struct rb_node *parent = rb_parent(old);
+	struct rb_node *cur[FIND_BATCH], *node;
+	size_t base, i, g, left;
+	int ret;
 
-	if (old == tree->root)
-		tree->root = new;
-	else if (old == parent->left)
-		parent->left = new;
-	else
-		parent->right = new;
-	if (new)
-		rb_set_parent(new, parent);
-}
-
-static void inline rotate(struct rb_tree *tree, struct rb_node *x)
-{
-	struct rb_node *p = rb_parent(x);
-	struct rb_node *g = rb_parent(p);
-
-	if (p == g->left) {
-		// Left left case
-		if (x == p->left) {
-			rb_set_color(p, RB_BLACK);
-			rb_set_color(g, RB_RED);
-			g->left = p->right;
-			if (p->right)
-				rb_set_parent(p->right, g);
-			p->right = g;
-			replace(tree, g, p);
-			rb_set_parent(g, p);
+	for (base = 0; base < n; base += g) {
+		g = n - base < FIND_BATCH ? n - base : FIND_BATCH;
+		for (i = 0; i < g; i++) {
+			cur[i] = tree->root;
+			out[base + i] = NULL;
 		}
 
-		// Left right case
-		else {
-			rb_set_color(x, RB_BLACK);
-			rb_set_color(g, RB_RED);
-			p->right = x->left;
-			if (x->left)
-				rb_set_parent(x->left, p);
-			g->left = x->right;
-			if (x->right)
-				rb_set_parent(x->right, g);
-			x->left = p;
-			x->right = g;
-			replace(tree, g, x);
-			rb_set_parent(p, x);
-			rb_set_parent(g, x);
+		// one step of every descent per round
+		left = tree->root ? g : 0;
+		while (left) {
+			for (i = 0; i < g; i++) {
+				node = cur[i];
+				if (!node)
+					continue;
+
+				ret = cmp(node, keys[base + i]);
+				if (ret < 0)
+					node = node->left;
+				else if (ret > 0)
+					node = node->right;
+				else {
+					out[base + i] = node;
+					node = NULL;
+				}
+
+				if (node)
+					__builtin_prefetch(node);
+				else
+					left--;
+				cur[i] = node;
+			}
 		}
 	}
+}
 
-	else {
-		// Right left case
-		if (x == p->left) {
-			rb_set_color(x, RB_BLACK);
-			rb_set_color(g, RB_RED);
-			p->left = x->right;
-			if (x->right)
-				rb_set_parent(x->right, p);
-			g->right = x->left;
-			if (x->left)
-				rb_set_parent(x->left, g);
-			x->left = g;
-			x->right = p;
-			replace(tree, g, x);
-			rb_set_parent(p, x);
-			rb_set_parent(g, x);
-		}
+// x was unlinked below parent, fix the augmented data from there up.
+// if x was swapped with its successor n, n holds x's old data and the
+// path between them is updated first
+static inline void augment_unlinked(struct rb_node *parent, struct rb_node *n,
+		const struct rb_augment_callbacks *aug)
+{
+	if (!aug)
+		return;
+	if (parent)
+		aug->propagate(parent, n);
+	if (n)
+		aug->propagate(n, NULL);
+}
 
-		// Right right case
-		else {
-			rb_set_color(p, RB_BLACK);
-			rb_set_color(g, RB_RED);
-			g->right = p->left;
-			if (p->left)
-				rb_set_parent(p->left, g);
-			p->left = g;
-			replace(tree, g, p);
-			rb_set_parent(g, p);
-		}
-	}
+#define RB_FIX_TREE			struct rb_tree
+#define RB_FIX_REF			struct rb_node *
+#define RB_FIX_NIL			NULL
+#define RB_FIX_ROOT(t)			((t)->root)
+#define RB_FIX_SET_ROOT(t, n)		WRITE_LINK((t)->root, n)
+#define RB_FIX_PARENT(t, n)		rb_parent(n)
+#define RB_FIX_SET_PARENT(t, n, p)	rb_set_parent(n, p)
+#define RB_FIX_COLOR(t, n)		rb_color(n)
+#define RB_FIX_SET_COLOR(t, n, c)	rb_set_color(n, c)
+#define RB_FIX_LEFT(t, n)		((n)->left)
+#define RB_FIX_SET_LEFT(t, n, c)	WRITE_LINK((n)->left, c)
+#define RB_FIX_RIGHT(t, n)		((n)->right)
+#define RB_FIX_SET_RIGHT(t, n, c)	WRITE_LINK((n)->right, c)
+#define RB_FIX_AUG_ROTATE(old, new)	do { if (aug) aug->rotate(old, new); } while (0)
+#define RB_FIX_AUG_COPY(old, new)	do { if (aug) aug->copy(old, new); } while (0)
+#define RB_FIX_AUG_UNLINKED(p, n)	augment_unlinked(p, n, aug)
+#include "rbtree-fixup.h"
+
+// link a new RED leaf at *link, below parent
+static inline void link_node(struct rb_node *node, struct rb_node *parent,
+		struct rb_node **link)
+{
+	// make the colour of newly inserted nodes as RED
+	node->left = NULL;
+	node->right = NULL;
+	rb_set_parent_color(node, parent, RB_RED);
+	PUBLISH_LINK(*link, node);
+}
+
+void rb_insert_color(struct rb_tree *tree, struct rb_node *node)
+{
+	insert_fixup(tree, node, rb_parent(node), NULL);
 }
 
 int rb_insert(struct rb_tree *tree, struct rb_node *node,
@@ -214,10 +375,6 @@ int rb_insert(struct rb_tree *tree, struct rb_node *node,
 	struct rb_node *parent = NULL;
 	int ret;
 
-	// make the colour of newly inserted nodes as RED
-	node->left = NULL;
-	node->right = NULL;
-
 	// Perform standard BST insertion
 	while (*tmp) {
 		parent = *tmp;
@@ -229,243 +386,574 @@ int rb_insert(struct rb_tree *tree, struct rb_node *node,
 		else
 			return 0;
 	}
-	*tmp = node;
-	rb_set_parent_color(node, parent, RB_RED);
 
-	// Condition 1, If x is the root, change the colour of x as BLACK
-	if (tree->root == node) {
-		rb_set_color(node, RB_BLACK);
-		return 1;
+	link_node(node, parent, tmp);
+	insert_fixup(tree, node, parent, NULL);
+	return 1;
+}
+
+void rb_insert_multi(struct rb_tree *tree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	struct rb_node **tmp = &tree->root;
+	struct rb_node *parent = NULL;
+
+	// equal keys go right, after the nodes already there
+	while (*tmp) {
+		parent = *tmp;
+		if (cmp(parent, node) < 0)
+			tmp = &parent->left;
+		else
+			tmp = &parent->right;
 	}
 
-	// Condition 2, If parent is BLACK, insert done
+	link_node(node, parent, tmp);
+	insert_fixup(tree, node, parent, NULL);
+}
+
+struct rb_node *rb_equal_range(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_node **last)
+{
+	struct rb_node *node = tree->root, *first, *n;
+	int ret;
+
+	// the first node with key met splits the run in two
+	while (node) {
+		ret = cmp(node, key);
+		if (ret < 0)
+			node = node->left;
+		else if (ret > 0)
+			node = node->right;
+		else
+			break;
+	}
 
-	// Condition 3, parent is red
-	while (rb_color(parent) == RB_RED) {
-		struct rb_node *uncle, *grandpa;
+	*last = node;
+	if (!node)
+		return NULL;
 
-		grandpa = rb_parent(parent);
-		uncle = (parent == grandpa->left) ? grandpa->right : grandpa->left;
+	// its left subtree holds the start of the run
+	first = node;
+	for (n = node->left; n; ) {
+		if (cmp(n, key) <= 0) {
+			first = n;
+			n = n->left;
+		} else {
+			n = n->right;
+		}
+	}
 
-		// 3.1 uncle is red
-		if (uncle && rb_color(uncle) == RB_RED) {
+	// and its right subtree the end
+	for (n = node->right; n; ) {
+		if (cmp(n, key) < 0) {
+			n = n->left;
+		} else {
+			*last = n;
+			n = n->right;
+		}
+	}
 
-			// change parent and uncle to BLACK
-			rb_set_color(parent, RB_BLACK);
-			rb_set_color(uncle, RB_BLACK);
+	return first;
+}
 
-			// 3.1.1 grandpa is root, insert done
-			if (grandpa == tree->root)
+/*
+ * insert node starting from finger, a node already in the tree.
+ *
+ * if node > finger, the nodes greater than finger are met climbing up
+ * from finger each time we come from a left child. the first of them
+ * greater than node bounds the search, and the slot is in the right
+ * subtree of the last node passed that is less than node. nodes passed
+ * coming from a right child are less than finger and not compared.
+ * node < finger is the mirror.
+ */
+static int insert_from(struct rb_tree *tree, struct rb_node *finger,
+		struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	struct rb_node *c = finger, *bound = finger, *p;
+	struct rb_node **tmp;
+	int ret, dir;
+
+	dir = cmp(finger, node);
+	if (dir == 0)
+		return 0;
+
+	while ((p = rb_parent(c))) {
+		if (dir > 0 ? c == p->left : c == p->right) {
+			ret = cmp(p, node);
+			if (ret == 0)
+				return 0;
+			if ((ret > 0) != (dir > 0))
 				break;
+			bound = p;
+		}
+		c = p;
+	}
 
-			// 3.1.2 grandpa is not root, change its color to RED
-			rb_set_color(grandpa, RB_RED);
+	// Perform standard BST insertion below bound
+	p = bound;
+	tmp = dir > 0 ? &bound->right : &bound->left;
+	while (*tmp) {
+		p = *tmp;
+		ret = cmp(p, node);
+		if (ret < 0)
+			tmp = &p->left;
+		else if (ret > 0)
+			tmp = &p->right;
+		else
+			return 0;
+	}
 
-			// set x to grandpa, and continue to check
-			node = grandpa;
-			parent = rb_parent(node);
+	link_node(node, p, tmp);
+	insert_fixup(tree, node, p, NULL);
+	return 1;
+}
+
+int rb_insert_hint(struct rb_tree *tree, struct rb_node *hint,
+		struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	if (!hint)
+		return rb_insert(tree, node, cmp);
+	return insert_from(tree, hint, node, cmp);
+}
 
-			continue;
+size_t rb_insert_batch(struct rb_tree *tree, struct rb_node **nodes, size_t n,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	struct rb_node *finger = NULL;
+	size_t i, count = 0;
+	int ret;
+
+	for (i = 0; i < n; i++) {
+		if (finger)
+			ret = insert_from(tree, finger, nodes[i], cmp);
+		else
+			ret = rb_insert(tree, nodes[i], cmp);
+		if (ret) {
+			finger = nodes[i];
+			count++;
 		}
+	}
+
+	return count;
+}
 
-		// 3.2 uncle is BLACK, we need recoloring and rotating
-		rotate(tree, node);
+int rb_insert_augmented(struct rb_tree *tree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		const struct rb_augment_callbacks *aug)
+{
+	struct rb_node **tmp = &tree->root;
+	struct rb_node *parent = NULL;
+	int ret;
 
-		// after recoloring and rotating, the tree is balanced
-		break;
+	while (*tmp) {
+		parent = *tmp;
+		ret = cmp(parent, node);
+		if (ret < 0)
+			tmp = &parent->left;
+		else if (ret > 0)
+			tmp = &parent->right;
+		else
+			return 0;
 	}
 
+	link_node(node, parent, tmp);
+
+	// the path to the new leaf must be up to date before rotating
+	if (parent)
+		aug->propagate(parent, NULL);
+	insert_fixup(tree, node, parent, aug);
 	return 1;
 }
 
-void rb_delete(struct rb_tree *tree, struct rb_node *x)
+// depth of the deepest level of a balanced tree with n nodes
+static inline int last_depth(size_t n)
 {
-	struct rb_node *s, *p;
-	struct rb_node *m, *n;
+	int depth = 0;
 
-	// Conditon 3, the deleted node has 2 childs
-	if (x->left && x->right)
-	{
-		int color = rb_color(x);
+	while (n >>= 1)
+		depth++;
+	return depth;
+}
 
-		m = x->right;	// m is right child
-		n = m;
-		while (n->left)
-			n = n->left; // n is leftmost node
+/*
+ * splitting at the middle fills every level but the last, painting the
+ * last level RED keeps the black height equal on every path
+ */
+static struct rb_node *build_sorted(struct rb_node **nodes, size_t n,
+		struct rb_node *parent, int depth, int red)
+{
+	struct rb_node *node;
+	size_t mid;
 
-		rb_set_color(x, rb_color(n));
-		rb_set_color(n, color);
+	if (!n)
+		return NULL;
 
-		n->left = x->left;
-		if (x->left)
-			rb_set_parent(x->left, n);
-		x->left = NULL;
-		x->right = n->right;
+	mid = (n - 1) / 2;
+	node = nodes[mid];
+	rb_set_parent_color(node, parent, depth == red ? RB_RED : RB_BLACK);
+	node->left = build_sorted(nodes, mid, node, depth + 1, red);
+	node->right = build_sorted(nodes + mid + 1, n - mid - 1, node,
+			depth + 1, red);
+	return node;
+}
 
-		n->right = m;
-		rb_set_parent(m, n);
+void rb_build_sorted(struct rb_tree *tree, struct rb_node **nodes, size_t n)
+{
+	tree->root = build_sorted(nodes, n, NULL, 0, last_depth(n));
+	if (tree->root)
+		rb_set_color(tree->root, RB_BLACK);
+}
 
-		m = rb_parent(n);	// cache leftmost's parent to m
-		replace(tree, x, n);
+// same shape as build_sorted, built in order while consuming the list
+static struct rb_node *build_list(struct rb_node **head, size_t n,
+		int depth, int red)
+{
+	struct rb_node *node, *left;
+	size_t mid;
 
-		if (n->right == n) {	// leftmost is x's right child
-			n->right = x;
-			rb_set_parent(x, n);
-		}
-		else {
-			m->left = x;
-			rb_set_parent(x, m);
-		}
+	if (!n)
+		return NULL;
+
+	mid = (n - 1) / 2;
+	left = build_list(head, mid, depth + 1, red);
+
+	node = *head;
+	*head = node->right;
+
+	rb_set_parent_color(node, NULL, depth == red ? RB_RED : RB_BLACK);
+	node->left = left;
+	if (left)
+		rb_set_parent(left, node);
+	node->right = build_list(head, n - mid - 1, depth + 1, red);
+	if (node->right)
+		rb_set_parent(node->right, node);
+	return node;
+}
+
+void rb_build_sorted_list(struct rb_tree *tree, struct rb_node *head)
+{
+	struct rb_node *node;
+	size_t n = 0;
+
+	for (node = head; node; node = node->right)
+		n++;
+
+	tree->root = build_list(&head, n, 0, last_depth(n));
+	if (tree->root)
+		rb_set_color(tree->root, RB_BLACK);
+}
+
+void rb_init_cached(struct rb_tree_cached *tree)
+{
+	tree->tree.root = NULL;
+	tree->leftmost = NULL;
+	tree->rightmost = NULL;
+}
+
+int rb_insert_cached(struct rb_tree_cached *tree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *))
+{
+	struct rb_node **tmp = &tree->tree.root;
+	struct rb_node *parent = NULL;
+	int leftmost = 1, rightmost = 1;
+	int ret;
 
-		// fallthrough to process leftmost deletion
+	// same descent as rb_insert, a node that never goes right
+	// (or never goes left) is the new leftmost (or rightmost)
+	while (*tmp) {
+		parent = *tmp;
+		ret = cmp(parent, node);
+		if (ret < 0) {
+			tmp = &parent->left;
+			rightmost = 0;
+		} else if (ret > 0) {
+			tmp = &parent->right;
+			leftmost = 0;
+		} else
+			return 0;
 	}
 
-	// Condition 2, has only one child
-	if (x->left || x->right)
-	{
-		m = x->left ? : x->right;
-		replace(tree, x, m);
+	link_node(node, parent, tmp);
+	insert_fixup(&tree->tree, node, parent, NULL);
 
-		// if any is red, delete done
-		if (rb_color(x) == RB_RED || rb_color(m) == RB_RED) {
-			rb_set_color(m, RB_BLACK);
-			return;
-		}
+	if (leftmost)
+		tree->leftmost = node;
+	if (rightmost)
+		tree->rightmost = node;
+	return 1;
+}
 
-		// if both is black, fallthrough to fixup
-		p = m;
-		s = NULL;
+void rb_delete(struct rb_tree *tree, struct rb_node *x)
+{
+	delete_node(tree, x, NULL);
+}
+
+struct rb_node *rb_delete_first(struct rb_tree *tree, struct rb_node *x)
+{
+	struct rb_node *p = rb_parent(x), *r = x->right;
+
+	// no left child, so no successor to swap in. a right child is a
+	// RED leaf, it takes x's place as BLACK and is the new first node
+	if (r) {
+		replace(tree, x, r);
+		rb_set_color(r, RB_BLACK);
+		return r;
 	}
 
-	// Condition 1, no child
+	// x is a leaf, and p->left if p is not NULL
+	replace(tree, x, NULL);
+	if (p && rb_color(x) == RB_BLACK)
+		delete_fixup(tree, p, p->right, NULL);
+	return p;
+}
+
+void rb_delete_augmented(struct rb_tree *tree, struct rb_node *x,
+		const struct rb_augment_callbacks *aug)
+{
+	delete_node(tree, x, aug);
+}
+
+void rb_replace(struct rb_tree *tree, struct rb_node *old, struct rb_node *node)
+{
+	struct rb_node *parent = rb_parent(old);
+
+	// node takes old's links and color before it is published
+	*node = *old;
+	if (old->left)
+		rb_set_parent(old->left, node);
+	if (old->right)
+		rb_set_parent(old->right, node);
+
+	if (!parent)
+		PUBLISH_LINK(tree->root, node);
+	else if (old == parent->left)
+		PUBLISH_LINK(parent->left, node);
+	else
+		PUBLISH_LINK(parent->right, node);
+}
+
+void rb_delete_cached(struct rb_tree_cached *tree, struct rb_node *node)
+{
+	// leftmost has no left child, and a single right child must be a
+	// RED leaf, so the next node is either that child or the parent.
+	// the same holds for rightmost mirrored.
+	if (node == tree->leftmost)
+		tree->leftmost = node->right ? node->right : rb_parent(node);
+	if (node == tree->rightmost)
+		tree->rightmost = node->left ? node->left : rb_parent(node);
+
+	rb_delete(&tree->tree, node);
+}
+
+struct rb_node *rb_pop_first_cached(struct rb_tree_cached *tree)
+{
+	struct rb_node *node = tree->leftmost;
+
+	if (!node)
+		return NULL;
+	// a node both leftmost and rightmost has no children, it was alone
+	if (node == tree->rightmost)
+		tree->rightmost = NULL;
+	tree->leftmost = rb_delete_first(&tree->tree, node);
+	return node;
+}
+
+// black nodes on the path from node to a leaf
+static inline int black_height(struct rb_node *node)
+{
+	int h = 0;
+
+	for (; node; node = node->left)
+		h += rb_color(node) == RB_BLACK;
+	return h;
+}
+
+/*
+ * join l, pivot and r into tree, l and r have BLACK roots and black
+ * height lh and rh. returns the black height of tree.
+ *
+ * walk down the right spine of the higher tree (left spine if r is
+ * higher) to the first BLACK node y as high as the other tree, pivot
+ * replaces y as a RED node with y and the other tree as children, then
+ * fix a RED parent the same way as an insert. O(|lh - rh| + 1)
+ */
+static int join(struct rb_tree *tree, struct rb_node *l, int lh,
+		struct rb_node *pivot, struct rb_node *r, int rh)
+{
+	struct rb_node *parent = NULL, *y;
+	struct rb_node **link = &tree->root;
+	int h, grew;
+
+	if (lh >= rh) {
+		tree->root = y = l;
+		h = lh;
+		while (h > rh || (y && rb_color(y) == RB_RED)) {
+			h -= rb_color(y) == RB_BLACK;
+			parent = y;
+			link = &y->right;
+			y = y->right;
+		}
+		pivot->left = y;
+		pivot->right = r;
+		h = lh;
+	}
 	else {
-		p = rb_parent(x);
-		if (p)
-			s = (x == p->left) ? p->right : p->left;
-		else
-			s = NULL;
+		tree->root = y = r;
+		h = rh;
+		while (h > lh || (y && rb_color(y) == RB_RED)) {
+			h -= rb_color(y) == RB_BLACK;
+			parent = y;
+			link = &y->left;
+			y = y->left;
+		}
+		pivot->left = l;
+		pivot->right = y;
+		h = rh;
+	}
+
+	if (pivot->left)
+		rb_set_parent(pivot->left, pivot);
+	if (pivot->right)
+		rb_set_parent(pivot->right, pivot);
+	rb_set_parent_color(pivot, parent, RB_RED);
+	*link = pivot;
+
+	grew = insert_fixup(tree, pivot, parent, NULL);
+	return h + grew;
+}
 
-		replace(tree, x, NULL);
+void rb_join(struct rb_tree *t1, struct rb_node *pivot, struct rb_tree *t2)
+{
+	struct rb_tree tree;
 
-		// 1.1 the deleted node is red, delete done
-		if (rb_color(x) == RB_RED)
+	if (!pivot) {
+		if (!t2->root)
 			return;
+		pivot = rb_first(t2);
+		rb_delete(t2, pivot);
+	}
+
+	join(&tree, t1->root, black_height(t1->root),
+			pivot, t2->root, black_height(t2->root));
+	t1->root = tree.root;
+	t2->root = NULL;
+}
 
-		// 1.2 the deleted node is black, fallthrough to fixup
+// make a child a BLACK root, h is its black height
+static inline struct rb_node *detach(struct rb_node *node, int *h)
+{
+	if (node) {
+		if (rb_color(node) == RB_RED)
+			(*h)++;
+		rb_set_parent_color(node, NULL, RB_BLACK);
 	}
+	return node;
+}
 
-	// rotating and recoloring
-	while (p) {
-		// sibling is black
-		if (!s || rb_color(s) == RB_BLACK)
-		{
-			// b) its both children are black
-			if (!s || ((!s->left || rb_color(s->left) == RB_BLACK) &&
-					(!s->right || rb_color(s->right) == RB_BLACK)))
-			{
-				struct rb_node *parent;
+/*
+ * split the subtree node with BLACK root and black height h. going down
+ * towards key, the part on the other side of each node is joined with
+ * it into lo or hi. the black heights of the joined trees grow along
+ * the path, so the joins sum up to O(log n)
+ */
+static struct rb_node *split(struct rb_node *node, int h, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_node **lo, int *lh, struct rb_node **hi, int *hh)
+{
+	struct rb_node *l, *r, *found;
+	struct rb_tree tree;
+	int ret, sh, th = h - 1;
 
-				if (s)
-					rb_set_color(s, RB_RED);
+	if (!node) {
+		*lo = *hi = NULL;
+		*lh = *hh = 0;
+		return NULL;
+	}
 
-				if (rb_color(p) == RB_RED) {
-					rb_set_color(p, RB_BLACK);
-					return;
-				}
+	sh = th;
+	l = detach(node->left, &sh);
+	r = detach(node->right, &th);
 
-				parent = rb_parent(p);
-				if (parent)
-					s = (p == parent->left) ? parent->right : parent->left;
-				p = parent;
-				continue;
-			}
+	ret = cmp(node, key);
+	if (ret < 0) {
+		// node and r are greater than key
+		found = split(l, sh, key, cmp, lo, lh, &l, &sh);
+		*hh = join(&tree, l, sh, node, r, th);
+		*hi = tree.root;
+	}
+	else if (ret > 0) {
+		found = split(r, th, key, cmp, &r, &th, hi, hh);
+		*lh = join(&tree, l, sh, node, r, th);
+		*lo = tree.root;
+	}
+	else {
+		*lo = l;
+		*lh = sh;
+		*hi = r;
+		*hh = th;
+		found = node;
+	}
 
-			// a) at least one child is red
-			if (s == p->right) {
-				if (s->right && rb_color(s->right) == RB_RED) {
-					rb_set_color(s->right, RB_BLACK);
-					rb_set_color(s, rb_color(p));
-					rb_set_color(p, RB_BLACK);
-					p->right = s->left;
-					if (s->left)
-						rb_set_parent(s->left, p);
-					s->left = p;
-					replace(tree, p, s);
-					rb_set_parent(p, s);
-				}
-				else {
-					m = s->left;
-					rb_set_color(m, rb_color(p));
-					rb_set_color(p, RB_BLACK);
-					replace(tree, p, m);
-					p->right = m->left;
-					if (m->left)
-						rb_set_parent(m->left, p);
-					s->left = m->right;
-					if (m->right)
-						rb_set_parent(m->right, s);
-					m->left = p;
-					rb_set_parent(p, m);
-					m->right = s;
-					rb_set_parent(s, m);
-				}
-			}
-			else {
-				if (s->left && rb_color(s->left) == RB_RED) {
-					rb_set_color(s->left, RB_BLACK);
-					rb_set_color(s, rb_color(p));
-					rb_set_color(p, RB_BLACK);
-					p->left = s->right;
-					if (s->right)
-						rb_set_parent(s->right, p);
-					s->right = p;
-					replace(tree, p, s);
-					rb_set_parent(p, s);
-				}
-				else {
-					m = s->right;
-					rb_set_color(m, rb_color(p));
-					rb_set_color(p, RB_BLACK);
-					replace(tree, p, m);
-					p->left = m->right;
-					if (m->right)
-						rb_set_parent(m->right, p);
-					s->right = m->left;
-					if (m->left)
-						rb_set_parent(m->left, s);
-					m->right = p;
-					rb_set_parent(p, m);
-					m->left = s;
-					rb_set_parent(s, m);
-				}
-			}
+	return found;
+}
 
-			return;
-		}
+struct rb_node *rb_split(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_tree *lo, struct rb_tree *hi)
+{
+	struct rb_node *root = tree->root, *found, *l, *r;
+	int lh, rh;
+
+	tree->root = NULL;
+	found = split(root, black_height(root), key, cmp, &l, &lh, &r, &rh);
+	lo->root = l;
+	hi->root = r;
+	return found;
+}
 
-		else {
-			// c) sibling is red
-			replace(tree, p, s);
+// ranges up to this many nodes are deleted node by node
+#define RANGE_SMALL 32
 
-			rb_set_parent(p, s);
-			rb_set_color(p, RB_RED);
-			rb_set_color(s, RB_BLACK);
+size_t rb_delete_range(struct rb_tree *tree, const void *lo, const void *hi,
+		int (*cmp)(struct rb_node *, const void *),
+		void (*free_cb)(struct rb_node *))
+{
+	struct rb_range_iter iter;
+	struct rb_node *node, *next, *pivot;
+	struct rb_tree mid, right;
+	size_t n = 0;
+
+	// delete the first nodes one by one, a short range ends there
+	for (node = rb_range_first(&iter, tree, lo, hi, cmp); node;
+			node = rb_range_next(&iter)) {
+		rb_delete(tree, node);
+		if (free_cb)
+			free_cb(node);
+		if (++n == RANGE_SMALL || !iter.next)
+			break;
+	}
+	if (!iter.next)
+		return n;
+
+	// tree < lo <= mid < hi <= right, a node equal to hi joins them
+	node = rb_split(tree, lo, cmp, tree, &mid);
+	pivot = rb_split(&mid, hi, cmp, &mid, &right);
+	if (node) {
+		if (free_cb)
+			free_cb(node);
+		n++;
+	}
 
-			if (s == p->right) {
-				p->right = s->left;
-				if (s->left)
-					rb_set_parent(s->left, p);
-				s->left = p;
-				s = p->right; // update p s and continue
-			}
-			else {
-				p->left = s->right;
-				if (s->right)
-					rb_set_parent(s->right, p);
-				s->right = p;
-				s = p->left;
-			}
-		}
+	for (node = rb_first_postorder(&mid); node; node = next) {
+		next = rb_next_postorder(node);
+		if (free_cb)
+			free_cb(node);
+		n++;
 	}
-}
 
+	rb_join(tree, pivot, &right);
+	return n;
+}
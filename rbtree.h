@@ -7,6 +7,12 @@
 #ifndef RBTREE_H
 #define RBTREE_H
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define RB_RED 0
 #define RB_BLACK 1
 
@@ -20,12 +26,23 @@ struct rb_tree {
 	struct rb_node *root;
 };
 
-#define rb_parent(n) ((struct rb_node *)(n->parent & ~ 3))
+/*
+ * rb_tree with the leftmost and rightmost nodes cached, so first/last
+ * are O(1) and popping the minimum doesn't walk the left spine.
+ * only use the _cached functions to modify it.
+ */
+struct rb_tree_cached {
+	struct rb_tree tree;
+	struct rb_node *leftmost;
+	struct rb_node *rightmost;
+};
+
+#define rb_parent(n) ((struct rb_node *)((n)->parent & ~ 3))
 #define rb_color(n) ((n)->parent & 1)
 
 static int inline rb_empty(struct rb_tree *tree)
 {
-	return tree->root == (void *)0;
+	return tree->root == NULL;
 }
 
 void rb_init(struct rb_tree *tree);
@@ -37,19 +54,278 @@ struct rb_node *rb_next(struct rb_node *node);
 struct rb_node *rb_next_from(struct rb_tree *tree, const void *key,
 		int (*cmp)(struct rb_node *, const void *));
 
+struct rb_node *rb_last(struct rb_tree *tree);
+
+struct rb_node *rb_prev(struct rb_node *node);
+
+// last node less than key, the mirror of rb_next_from()
+struct rb_node *rb_prev_from(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *));
+
 struct rb_node *rb_find(struct rb_tree *tree, const void *key,
 		int (*cmp)(struct rb_node *, const void *));
 
+/*
+ * single descent searches, cmp as for rb_find(). lower bound is the
+ * first node not less than key, upper bound the first greater, floor
+ * the last not greater and ceil the first not less
+ */
+struct rb_node *rb_lower_bound(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *));
+
+struct rb_node *rb_floor(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *));
+
+static inline struct rb_node *rb_upper_bound(struct rb_tree *tree,
+		const void *key, int (*cmp)(struct rb_node *, const void *))
+{
+	return rb_next_from(tree, key, cmp);
+}
+
+static inline struct rb_node *rb_ceil(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *))
+{
+	return rb_lower_bound(tree, key, cmp);
+}
+
+/*
+ * the node with key, or NULL with *parent and *link set to where a node
+ * with key goes. link it there with rb_link_node() and rebalance with
+ * rb_insert_color(), before any other change to the tree:
+ *
+ *	if (!rb_find_or_insert_pos(tree, &key, cmp, &parent, &link)) {
+ *		rb_link_node(&new->node, parent, link);
+ *		rb_insert_color(tree, &new->node);
+ *	}
+ */
+struct rb_node *rb_find_or_insert_pos(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_node **parent, struct rb_node ***link);
+
+/*
+ * rb_find() for keys[0] to keys[n - 1], results in out. the descents
+ * are interleaved and prefetch the next node, so their cache misses
+ * overlap instead of following each other
+ */
+void rb_find_batch(struct rb_tree *tree, const void *const keys[], size_t n,
+		int (*cmp)(struct rb_node *, const void *), struct rb_node *out[]);
+
 int rb_insert(struct rb_tree *tree, struct rb_node *node,
 		int (*cmp)(struct rb_node *, struct rb_node *));
 
+/*
+ * insert node even if nodes with the same key are in the tree, it goes
+ * after them, so equal keys keep their insertion order
+ */
+void rb_insert_multi(struct rb_tree *tree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *));
+
+/*
+ * first node with key, NULL if none, and the last one in *last. the
+ * run is walked with rb_next() from the first to the last
+ */
+struct rb_node *rb_equal_range(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_node **last);
+
 void rb_delete(struct rb_tree *tree, struct rb_node *node);
 
+/*
+ * delete node, the first of the tree, cheaper than rb_delete() as it has
+ * no left child. returns the new first node
+ */
+struct rb_node *rb_delete_first(struct rb_tree *tree, struct rb_node *node);
+
+/*
+ * put node in old's place in O(1), taking its links and color, nothing is
+ * compared or rebalanced. node must sort the same as old, e.g. a newer
+ * version of the same entry. old is left out of the tree
+ */
+void rb_replace(struct rb_tree *tree, struct rb_node *old, struct rb_node *node);
+
+/*
+ * for callers doing their own descent: link node as a RED leaf at
+ * *link below parent, then rebalance with rb_insert_color()
+ */
+static inline void rb_link_node(struct rb_node *node, struct rb_node *parent,
+		struct rb_node **link)
+{
+	node->parent = (unsigned long)parent + RB_RED;
+	node->left = node->right = NULL;
+#ifdef RB_CONCURRENT
+	__atomic_store_n(link, node, __ATOMIC_RELEASE);
+#else
+	*link = node;
+#endif
+}
+
+void rb_insert_color(struct rb_tree *tree, struct rb_node *node);
+
+/*
+ * join t1, pivot and t2 into t1 in O(log n), t2 is left empty. all nodes
+ * of t1 must be less than pivot, and pivot less than all nodes of t2.
+ * if pivot is NULL, the first node of t2 is used.
+ */
+void rb_join(struct rb_tree *t1, struct rb_node *pivot, struct rb_tree *t2);
+
+/*
+ * split tree in O(log n), nodes less than key go to lo, greater to hi,
+ * tree is left empty. the node equal to key, if any, is in neither and
+ * returned. tree may be the same as lo or hi.
+ */
+struct rb_node *rb_split(struct rb_tree *tree, const void *key,
+		int (*cmp)(struct rb_node *, const void *),
+		struct rb_tree *lo, struct rb_tree *hi);
+
+/*
+ * rb_insert() with the search starting from hint, a node in the tree,
+ * instead of the root. with hint a close neighbor of node, e.g. the last
+ * node inserted in an ascending run, only a few nodes are compared.
+ * NULL hint is rb_insert()
+ */
+int rb_insert_hint(struct rb_tree *tree, struct rb_node *hint,
+		struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *));
+
+/*
+ * insert n nodes, each search starts from the previously inserted node
+ * instead of the root, so ascending, descending or clustered batches
+ * take amortized O(1) comparisons per node. random batches don't gain,
+ * sort them first. nodes equal to one already in the tree are skipped.
+ * returns the number of nodes inserted.
+ */
+size_t rb_insert_batch(struct rb_tree *tree, struct rb_node **nodes, size_t n,
+		int (*cmp)(struct rb_node *, struct rb_node *));
+
+/*
+ * build the tree from n nodes already in ascending order in O(n), no
+ * comparison is done. the previous content of tree is discarded.
+ */
+void rb_build_sorted(struct rb_tree *tree, struct rb_node **nodes, size_t n);
+
+// same as rb_build_sorted(), the nodes are chained through ->right
+void rb_build_sorted_list(struct rb_tree *tree, struct rb_node *head);
+
+/*
+ * augmented trees keep per-node data computed from the subtree, e.g. the
+ * subtree size or the max interval end. rb_insert_augmented() and
+ * rb_delete_augmented() call back on the O(log n) nodes they touch:
+ *
+ * propagate(node, stop): recompute node and its ancestors up to but not
+ *   including stop, it may return early once a value doesn't change.
+ * copy(old, new): new takes old's place, copy old's data to new.
+ * rotate(old, new): new replaced old as subtree root, copy old's data
+ *   to new, then recompute old.
+ *
+ * RB_DECLARE_CALLBACKS() generates all three from a compute function.
+ */
+struct rb_augment_callbacks {
+	void (*propagate)(struct rb_node *node, struct rb_node *stop);
+	void (*copy)(struct rb_node *, struct rb_node *);
+	void (*rotate)(struct rb_node *, struct rb_node *);
+};
+
+// the augmented data of node must be set up as a single node subtree
+int rb_insert_augmented(struct rb_tree *tree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *),
+		const struct rb_augment_callbacks *aug);
+
+void rb_delete_augmented(struct rb_tree *tree, struct rb_node *node,
+		const struct rb_augment_callbacks *aug);
+
+void rb_init_cached(struct rb_tree_cached *tree);
+
+#define rb_first_cached(t) ((t)->leftmost)
+#define rb_last_cached(t) ((t)->rightmost)
+
+int rb_insert_cached(struct rb_tree_cached *tree, struct rb_node *node,
+		int (*cmp)(struct rb_node *, struct rb_node *));
+
+void rb_delete_cached(struct rb_tree_cached *tree, struct rb_node *node);
+
+// remove and return the first node, NULL if the tree is empty
+struct rb_node *rb_pop_first_cached(struct rb_tree_cached *tree);
+
 #define rb_for_each(node, tree)	\
 	for (node = rb_first(tree); node; node = rb_next(node))
 
+#define rb_for_each_reverse(node, tree)	\
+	for (node = rb_last(tree); node; node = rb_prev(node))
+
+/*
+ * scan of the nodes in [lo, hi), cmp(node, key) as for rb_find(). the
+ * next node is looked up before the current one is returned, so that
+ * one may be deleted
+ */
+struct rb_range_iter {
+	struct rb_node *next;
+	const void *hi;
+	int (*cmp)(struct rb_node *, const void *);
+};
+
+struct rb_node *rb_range_first(struct rb_range_iter *iter,
+		struct rb_tree *tree, const void *lo, const void *hi,
+		int (*cmp)(struct rb_node *, const void *));
+
+struct rb_node *rb_range_next(struct rb_range_iter *iter);
+
+#define rb_for_each_range(node, iter, tree, lo, hi, cmp)	\
+	for (node = rb_range_first(iter, tree, lo, hi, cmp); node; \
+			node = rb_range_next(iter))
+
+/*
+ * delete the nodes in [lo, hi) and pass each to free_cb, if not NULL.
+ * a few nodes are deleted one by one, a larger range is cut out with
+ * two splits and a join. returns the number of nodes deleted.
+ */
+size_t rb_delete_range(struct rb_tree *tree, const void *lo, const void *hi,
+		int (*cmp)(struct rb_node *, const void *),
+		void (*free_cb)(struct rb_node *));
+
+#ifndef container_of
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
 #define rb_entry(node, type, member) container_of(node, type, member)
 
+/*
+ * rbcompute(rbstruct *) returns the augmented value of a node from its
+ * own fields and its children's rbaugmented.
+ */
+#define RB_DECLARE_CALLBACKS(rbstatic, rbname, rbstruct, rbfield,	\
+		rbtype, rbaugmented, rbcompute)				\
+static inline void rbname ## _propagate(struct rb_node *rb,		\
+		struct rb_node *stop)					\
+{									\
+	while (rb != stop) {						\
+		rbstruct *node = rb_entry(rb, rbstruct, rbfield);	\
+		rbtype augmented = rbcompute(node);			\
+		if (node->rbaugmented == augmented)			\
+			break;						\
+		node->rbaugmented = augmented;				\
+		rb = rb_parent(&node->rbfield);				\
+	}								\
+}									\
+static inline void rbname ## _copy(struct rb_node *rb_old,		\
+		struct rb_node *rb_new)					\
+{									\
+	rbstruct *old = rb_entry(rb_old, rbstruct, rbfield);		\
+	rbstruct *new = rb_entry(rb_new, rbstruct, rbfield);		\
+	new->rbaugmented = old->rbaugmented;				\
+}									\
+static inline void rbname ## _rotate(struct rb_node *rb_old,		\
+		struct rb_node *rb_new)					\
+{									\
+	rbstruct *old = rb_entry(rb_old, rbstruct, rbfield);		\
+	rbstruct *new = rb_entry(rb_new, rbstruct, rbfield);		\
+	new->rbaugmented = old->rbaugmented;				\
+	old->rbaugmented = rbcompute(old);				\
+}									\
+rbstatic const struct rb_augment_callbacks rbname = {			\
+	rbname ## _propagate, rbname ## _copy, rbname ## _rotate	\
+};
+
 struct rb_node *rb_first_postorder(struct rb_tree *tree);
 struct rb_node *rb_next_postorder(struct rb_node *node);
 
@@ -63,11 +339,19 @@ struct rb_node *rb_next_postorder(struct rb_node *node);
 		pos; \
 		pos = rb_entry_safe(rb_next(&pos->member), typeof(*pos), member))
 
+#define rb_for_each_entry_reverse(pos, tree, member)	\
+	for (pos = rb_entry_safe(rb_last(tree), typeof(*pos), member); \
+		pos; \
+		pos = rb_entry_safe(rb_prev(&pos->member), typeof(*pos), member))
+
 #define rbtree_postorder_for_each_entry_safe(pos, n, root, field) \
 	for (pos = rb_entry_safe(rb_first_postorder(root), typeof(*pos), field); \
 			pos && ({ n = rb_entry_safe(rb_next_postorder(&pos->field), \
 					typeof(*pos), field); 1; }); \
 					pos = n)
 
+#ifdef __cplusplus
+}
 #endif
 
+#endif
@@ -0,0 +1,841 @@
+/*
+ * C++ front end for rbtree.c
+ *
+ * rb::intrusive_set<T, &T::node, Compare> links objects that embed a
+ * struct rb_node, it never allocates. rb::map<K, V, Compare, Alloc>
+ * owns its nodes like std::map. both descend with the comparator
+ * inlined and rebalance with rb_insert_color()/rb_delete().
+ */
+
+#ifndef RBTREE_HPP
+#define RBTREE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include "rbtree.h"
+
+namespace rb {
+
+namespace detail {
+
+// Compare::is_transparent enables lookup by any comparable key
+template <class Compare, class K, class = void>
+struct key_arg {
+};
+
+template <class Compare, class K>
+struct key_arg<Compare, K, std::void_t<typename Compare::is_transparent>> {
+	typedef void type;
+};
+
+/*
+ * bidirectional iterator over a tree, end() is a NULL node, the tree is
+ * kept so --end() finds the last node
+ */
+template <class Value, class Traits>
+class iterator {
+public:
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef typename std::remove_const<Value>::type value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Value *pointer;
+	typedef Value &reference;
+
+	iterator() : node_(nullptr), tree_(nullptr) {}
+	iterator(rb_node *node, const rb_tree *tree)
+		: node_(node), tree_(tree) {}
+
+	// iterator converts to const_iterator
+	template <class V, class = typename std::enable_if<
+		std::is_same<const V, Value>::value &&
+		!std::is_same<V, Value>::value>::type>
+	iterator(const iterator<V, Traits> &it)
+		: node_(it.node()), tree_(it.tree()) {}
+
+	reference operator*() const { return Traits::value(node_); }
+	pointer operator->() const { return &Traits::value(node_); }
+
+	iterator &operator++()
+	{
+		node_ = rb_next(node_);
+		return *this;
+	}
+
+	iterator &operator--()
+	{
+		node_ = node_ ? rb_prev(node_) :
+			rb_last(const_cast<rb_tree *>(tree_));
+		return *this;
+	}
+
+	iterator operator++(int)
+	{
+		iterator it = *this;
+		++*this;
+		return it;
+	}
+
+	iterator operator--(int)
+	{
+		iterator it = *this;
+		--*this;
+		return it;
+	}
+
+	friend bool operator==(const iterator &a, const iterator &b)
+	{
+		return a.node_ == b.node_;
+	}
+
+	friend bool operator!=(const iterator &a, const iterator &b)
+	{
+		return a.node_ != b.node_;
+	}
+
+	rb_node *node() const { return node_; }
+	const rb_tree *tree() const { return tree_; }
+
+private:
+	rb_node *node_;
+	const rb_tree *tree_;
+};
+
+/*
+ * the descents shared by both containers, Traits::key(node) gives the
+ * key of a node
+ */
+template <class Traits, class Compare>
+struct search {
+	template <class K>
+	static rb_node *find(const rb_tree *tree, const Compare &comp,
+			const K &key)
+	{
+		rb_node *node = tree->root;
+
+		while (node) {
+			if (comp(key, Traits::key(node)))
+				node = node->left;
+			else if (comp(Traits::key(node), key))
+				node = node->right;
+			else
+				return node;
+		}
+		return nullptr;
+	}
+
+	// first node not less than key
+	template <class K>
+	static rb_node *lower_bound(const rb_tree *tree, const Compare &comp,
+			const K &key)
+	{
+		rb_node *node = tree->root, *want = nullptr;
+
+		while (node) {
+			if (comp(Traits::key(node), key))
+				node = node->right;
+			else {
+				want = node;
+				node = node->left;
+			}
+		}
+		return want;
+	}
+
+	// first node greater than key
+	template <class K>
+	static rb_node *upper_bound(const rb_tree *tree, const Compare &comp,
+			const K &key)
+	{
+		rb_node *node = tree->root, *want = nullptr;
+
+		while (node) {
+			if (comp(key, Traits::key(node))) {
+				want = node;
+				node = node->left;
+			} else
+				node = node->right;
+		}
+		return want;
+	}
+
+	// the slot for key, or the node equal to it
+	template <class K>
+	static rb_node *insert_pos(rb_tree *tree, const Compare &comp,
+			const K &key, rb_node **parent, rb_node ***link)
+	{
+		rb_node **tmp = &tree->root, *p = nullptr;
+
+		while (*tmp) {
+			p = *tmp;
+			if (comp(key, Traits::key(p)))
+				tmp = &p->left;
+			else if (comp(Traits::key(p), key))
+				tmp = &p->right;
+			else
+				return p;
+		}
+		*parent = p;
+		*link = tmp;
+		return nullptr;
+	}
+};
+
+} // namespace detail
+
+/*
+ * intrusive ordered set, T embeds a struct rb_node as Member. objects
+ * are linked, not copied, and must outlive their membership.
+ */
+template <class T, rb_node T::*Member, class Compare = std::less<T>>
+class intrusive_set {
+	struct traits {
+		static T &value(rb_node *node)
+		{
+			return *reinterpret_cast<T *>(
+				reinterpret_cast<char *>(node) - offset());
+		}
+		static const T &key(rb_node *node) { return value(node); }
+	};
+	typedef detail::search<traits, Compare> search;
+
+	/*
+	 * a member pointer gives no offset without an object, so it is
+	 * taken from the objects being linked. every node in a tree went
+	 * through link() first, and the value is the same for all of them
+	 */
+	static inline std::atomic<std::ptrdiff_t> offset_{0};
+
+	static std::ptrdiff_t offset()
+	{
+		return offset_.load(std::memory_order_relaxed);
+	}
+
+	static rb_node *link(T &value)
+	{
+		rb_node *node = &(value.*Member);
+		std::ptrdiff_t off = reinterpret_cast<char *>(node) -
+			reinterpret_cast<char *>(std::addressof(value));
+
+		if (offset() != off)
+			offset_.store(off, std::memory_order_relaxed);
+		return node;
+	}
+
+public:
+	typedef T value_type;
+	typedef T key_type;
+	typedef Compare key_compare;
+	typedef std::size_t size_type;
+	typedef detail::iterator<T, traits> iterator;
+	typedef detail::iterator<const T, traits> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	explicit intrusive_set(const Compare &comp = Compare())
+		: size_(0), comp_(comp) { rb_init(&tree_); }
+
+	intrusive_set(const intrusive_set &) = delete;
+	intrusive_set &operator=(const intrusive_set &) = delete;
+
+	intrusive_set(intrusive_set &&other) noexcept
+		: tree_(other.tree_), size_(other.size_), comp_(other.comp_)
+	{
+		rb_init(&other.tree_);
+		other.size_ = 0;
+	}
+
+	intrusive_set &operator=(intrusive_set &&other) noexcept
+	{
+		if (this != &other) {
+			tree_ = other.tree_;
+			size_ = other.size_;
+			comp_ = other.comp_;
+			rb_init(&other.tree_);
+			other.size_ = 0;
+		}
+		return *this;
+	}
+
+	iterator begin() { return iterator(rb_first(&tree_), &tree_); }
+	iterator end() { return iterator(nullptr, &tree_); }
+	const_iterator begin() const
+	{
+		return const_iterator(rb_first(const_cast<rb_tree *>(&tree_)),
+				&tree_);
+	}
+	const_iterator end() const { return const_iterator(nullptr, &tree_); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+
+	bool empty() const { return size_ == 0; }
+	size_type size() const { return size_; }
+
+	std::pair<iterator, bool> insert(T &value)
+	{
+		rb_node *parent, **slot;
+		rb_node *found = search::insert_pos(&tree_, comp_, value,
+				&parent, &slot);
+
+		if (found)
+			return std::make_pair(iterator(found, &tree_), false);
+
+		rb_link_node(link(value), parent, slot);
+		rb_insert_color(&tree_, link(value));
+		size_++;
+		return std::make_pair(iterator(link(value), &tree_), true);
+	}
+
+	iterator erase(iterator pos)
+	{
+		rb_node *next = rb_next(pos.node());
+
+		rb_delete(&tree_, pos.node());
+		size_--;
+		return iterator(next, &tree_);
+	}
+
+	void erase(T &value) { erase(iterator_to(value)); }
+
+	// unlink everything, the objects are not touched
+	void clear()
+	{
+		rb_init(&tree_);
+		size_ = 0;
+	}
+
+	iterator iterator_to(T &value) { return iterator(link(value), &tree_); }
+
+	template <class K, class = typename detail::key_arg<Compare, K>::type>
+	iterator find(const K &key)
+	{
+		return iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	iterator find(const T &key)
+	{
+		return iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	template <class K, class = typename detail::key_arg<Compare, K>::type>
+	iterator lower_bound(const K &key)
+	{
+		return iterator(search::lower_bound(&tree_, comp_, key), &tree_);
+	}
+
+	iterator lower_bound(const T &key)
+	{
+		return iterator(search::lower_bound(&tree_, comp_, key), &tree_);
+	}
+
+	template <class K, class = typename detail::key_arg<Compare, K>::type>
+	iterator upper_bound(const K &key)
+	{
+		return iterator(search::upper_bound(&tree_, comp_, key), &tree_);
+	}
+
+	iterator upper_bound(const T &key)
+	{
+		return iterator(search::upper_bound(&tree_, comp_, key), &tree_);
+	}
+
+	template <class K, class = typename detail::key_arg<Compare, K>::type>
+	const_iterator find(const K &key) const
+	{
+		return const_iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	const_iterator find(const T &key) const
+	{
+		return const_iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	template <class K, class = typename detail::key_arg<Compare, K>::type>
+	const_iterator lower_bound(const K &key) const
+	{
+		return const_iterator(search::lower_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	const_iterator lower_bound(const T &key) const
+	{
+		return const_iterator(search::lower_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	template <class K, class = typename detail::key_arg<Compare, K>::type>
+	const_iterator upper_bound(const K &key) const
+	{
+		return const_iterator(search::upper_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	const_iterator upper_bound(const T &key) const
+	{
+		return const_iterator(search::upper_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	template <class K>
+	bool contains(const K &key) const { return find(key) != end(); }
+
+	rb_tree *c_tree() { return &tree_; }
+
+private:
+	rb_tree tree_;
+	size_type size_;
+	Compare comp_;
+};
+
+/*
+ * owning ordered map with the same interface as std::map for the parts
+ * implemented, nodes come from Alloc and hold the rb_node and the value
+ */
+template <class K, class V, class Compare = std::less<K>,
+	class Alloc = std::allocator<std::pair<const K, V>>>
+class map {
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<const K, V> value_type;
+	typedef Compare key_compare;
+	typedef Alloc allocator_type;
+	typedef std::size_t size_type;
+
+private:
+	// derived from rb_node, so links cast back with static_cast even
+	// when value_type is not standard layout
+	struct node : rb_node {
+		value_type value;
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template
+		rebind_alloc<node> node_alloc;
+	typedef std::allocator_traits<node_alloc> node_traits;
+
+	struct traits {
+		static value_type &value(rb_node *n)
+		{
+			return static_cast<node *>(n)->value;
+		}
+		static const K &key(rb_node *n) { return value(n).first; }
+	};
+	typedef detail::search<traits, Compare> search;
+
+public:
+	typedef detail::iterator<value_type, traits> iterator;
+	typedef detail::iterator<const value_type, traits> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	// extracted node, owns it until inserted again
+	class node_type {
+	public:
+		node_type() : node_(nullptr) {}
+		node_type(node_type &&other) noexcept
+			: node_(other.node_), alloc_(std::move(other.alloc_))
+		{
+			other.node_ = nullptr;
+		}
+		node_type &operator=(node_type &&other) noexcept
+		{
+			if (this != &other) {
+				reset();
+				node_ = other.node_;
+				alloc_ = std::move(other.alloc_);
+				other.node_ = nullptr;
+			}
+			return *this;
+		}
+		~node_type() { reset(); }
+
+		bool empty() const { return !node_; }
+		explicit operator bool() const { return node_ != nullptr; }
+		// the key may be changed before inserting the node again
+		K &key() const { return const_cast<K &>(node_->value.first); }
+		V &mapped() const { return node_->value.second; }
+
+	private:
+		friend class map;
+
+		node_type(node *n, const node_alloc &alloc)
+			: node_(n), alloc_(alloc) {}
+
+		void reset()
+		{
+			if (node_) {
+				node_traits::destroy(alloc_, &node_->value);
+				node_traits::deallocate(alloc_, node_, 1);
+				node_ = nullptr;
+			}
+		}
+
+		node *node_;
+		node_alloc alloc_;
+	};
+
+	struct insert_return_type {
+		iterator position;
+		bool inserted;
+		node_type node;
+	};
+
+	explicit map(const Compare &comp = Compare(),
+			const Alloc &alloc = Alloc())
+		: size_(0), comp_(comp), alloc_(alloc) { rb_init(&tree_); }
+
+	map(std::initializer_list<value_type> init,
+			const Compare &comp = Compare(),
+			const Alloc &alloc = Alloc())
+		: map(comp, alloc)
+	{
+		for (const value_type &v : init)
+			emplace(v);
+	}
+
+	map(const map &other)
+		: size_(0), comp_(other.comp_),
+		alloc_(node_traits::select_on_container_copy_construction(
+				other.alloc_))
+	{
+		rb_init(&tree_);
+		copy_from(other);
+	}
+
+	map(map &&other) noexcept
+		: tree_(other.tree_), size_(other.size_),
+		comp_(std::move(other.comp_)), alloc_(std::move(other.alloc_))
+	{
+		rb_init(&other.tree_);
+		other.size_ = 0;
+	}
+
+	map &operator=(const map &other)
+	{
+		if (this != &other) {
+			clear();
+			comp_ = other.comp_;
+			copy_from(other);
+		}
+		return *this;
+	}
+
+	map &operator=(map &&other) noexcept
+	{
+		if (this != &other) {
+			clear();
+			std::swap(tree_, other.tree_);
+			std::swap(size_, other.size_);
+			comp_ = std::move(other.comp_);
+			alloc_ = std::move(other.alloc_);
+		}
+		return *this;
+	}
+
+	~map() { clear(); }
+
+	allocator_type get_allocator() const { return Alloc(alloc_); }
+
+	iterator begin() { return iterator(rb_first(&tree_), &tree_); }
+	iterator end() { return iterator(nullptr, &tree_); }
+	const_iterator begin() const
+	{
+		return const_iterator(rb_first(const_cast<rb_tree *>(&tree_)),
+				&tree_);
+	}
+	const_iterator end() const { return const_iterator(nullptr, &tree_); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+
+	bool empty() const { return size_ == 0; }
+	size_type size() const { return size_; }
+
+	void clear()
+	{
+		rb_node *n, *next;
+
+		for (n = rb_first_postorder(&tree_); n; n = next) {
+			next = rb_next_postorder(n);
+			free_node(static_cast<node *>(n));
+		}
+		rb_init(&tree_);
+		size_ = 0;
+	}
+
+	// construct the value in a new node, then look for its key
+	template <class... Args>
+	std::pair<iterator, bool> emplace(Args &&...args)
+	{
+		node *n = new_node(std::forward<Args>(args)...);
+		rb_node *parent, **slot;
+		rb_node *found = search::insert_pos(&tree_, comp_,
+				n->value.first, &parent, &slot);
+
+		if (found) {
+			free_node(n);
+			return std::make_pair(iterator(found, &tree_), false);
+		}
+		return std::make_pair(link(n, parent, slot), true);
+	}
+
+	// look for the key first, construct only when it is missing
+	template <class... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args &&...args)
+	{
+		rb_node *parent, **slot;
+		rb_node *found = search::insert_pos(&tree_, comp_, key,
+				&parent, &slot);
+
+		if (found)
+			return std::make_pair(iterator(found, &tree_), false);
+
+		node *n = new_node(std::piecewise_construct,
+				std::forward_as_tuple(key),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		return std::make_pair(link(n, parent, slot), true);
+	}
+
+	std::pair<iterator, bool> insert(const value_type &value)
+	{
+		return try_emplace(value.first, value.second);
+	}
+
+	std::pair<iterator, bool> insert(value_type &&value)
+	{
+		return emplace(std::move(value));
+	}
+
+	// relink an extracted node, no allocation
+	insert_return_type insert(node_type &&nh)
+	{
+		insert_return_type ret;
+		rb_node *parent, **slot;
+		rb_node *found;
+
+		if (nh.empty()) {
+			ret.position = end();
+			ret.inserted = false;
+			return ret;
+		}
+
+		found = search::insert_pos(&tree_, comp_, nh.node_->value.first,
+				&parent, &slot);
+		if (found) {
+			ret.position = iterator(found, &tree_);
+			ret.inserted = false;
+			ret.node = std::move(nh);
+			return ret;
+		}
+
+		ret.position = link(nh.node_, parent, slot);
+		ret.inserted = true;
+		nh.node_ = nullptr;
+		return ret;
+	}
+
+	V &operator[](const K &key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	V &at(const K &key)
+	{
+		iterator it = find(key);
+
+		if (it == end())
+			throw std::out_of_range("rb::map::at");
+		return it->second;
+	}
+
+	template <class Key, class = typename detail::key_arg<Compare, Key>::type>
+	iterator find(const Key &key)
+	{
+		return iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	iterator find(const K &key)
+	{
+		return iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	template <class Key, class = typename detail::key_arg<Compare, Key>::type>
+	const_iterator find(const Key &key) const
+	{
+		return const_iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	const_iterator find(const K &key) const
+	{
+		return const_iterator(search::find(&tree_, comp_, key), &tree_);
+	}
+
+	template <class Key, class = typename detail::key_arg<Compare, Key>::type>
+	iterator lower_bound(const Key &key)
+	{
+		return iterator(search::lower_bound(&tree_, comp_, key), &tree_);
+	}
+
+	iterator lower_bound(const K &key)
+	{
+		return iterator(search::lower_bound(&tree_, comp_, key), &tree_);
+	}
+
+	template <class Key, class = typename detail::key_arg<Compare, Key>::type>
+	iterator upper_bound(const Key &key)
+	{
+		return iterator(search::upper_bound(&tree_, comp_, key), &tree_);
+	}
+
+	iterator upper_bound(const K &key)
+	{
+		return iterator(search::upper_bound(&tree_, comp_, key), &tree_);
+	}
+
+	template <class Key, class = typename detail::key_arg<Compare, Key>::type>
+	const_iterator lower_bound(const Key &key) const
+	{
+		return const_iterator(search::lower_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	const_iterator lower_bound(const K &key) const
+	{
+		return const_iterator(search::lower_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	template <class Key, class = typename detail::key_arg<Compare, Key>::type>
+	const_iterator upper_bound(const Key &key) const
+	{
+		return const_iterator(search::upper_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	const_iterator upper_bound(const K &key) const
+	{
+		return const_iterator(search::upper_bound(&tree_, comp_, key),
+				&tree_);
+	}
+
+	template <class Key>
+	size_type count(const Key &key) const { return find(key) != end(); }
+
+	template <class Key>
+	bool contains(const Key &key) const { return find(key) != end(); }
+
+	iterator erase(const_iterator pos)
+	{
+		rb_node *next = rb_next(pos.node());
+
+		rb_delete(&tree_, pos.node());
+		size_--;
+		free_node(static_cast<node *>(pos.node()));
+		return iterator(next, &tree_);
+	}
+
+	iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+	size_type erase(const K &key)
+	{
+		iterator it = find(key);
+
+		if (it == end())
+			return 0;
+		erase(it);
+		return 1;
+	}
+
+	// unlink the node, it keeps its memory and value
+	node_type extract(const_iterator pos)
+	{
+		rb_delete(&tree_, pos.node());
+		size_--;
+		return node_type(static_cast<node *>(pos.node()), alloc_);
+	}
+
+	node_type extract(const K &key)
+	{
+		iterator it = find(key);
+
+		if (it == end())
+			return node_type();
+		return extract(const_iterator(it));
+	}
+
+	void swap(map &other)
+	{
+		std::swap(tree_, other.tree_);
+		std::swap(size_, other.size_);
+		std::swap(comp_, other.comp_);
+		std::swap(alloc_, other.alloc_);
+	}
+
+	rb_tree *c_tree() { return &tree_; }
+
+private:
+	template <class... Args>
+	node *new_node(Args &&...args)
+	{
+		node *n = node_traits::allocate(alloc_, 1);
+
+		try {
+			node_traits::construct(alloc_, &n->value,
+					std::forward<Args>(args)...);
+		} catch (...) {
+			node_traits::deallocate(alloc_, n, 1);
+			throw;
+		}
+		return n;
+	}
+
+	void free_node(node *n)
+	{
+		node_traits::destroy(alloc_, &n->value);
+		node_traits::deallocate(alloc_, n, 1);
+	}
+
+	iterator link(node *n, rb_node *parent, rb_node **slot)
+	{
+		rb_link_node(n, parent, slot);
+		rb_insert_color(&tree_, n);
+		size_++;
+		return iterator(n, &tree_);
+	}
+
+	// the source is in order, copy and build the tree in O(n)
+	void copy_from(const map &other)
+	{
+		std::unique_ptr<rb_node *[]> nodes(new rb_node *[other.size_]);
+		size_type i = 0;
+
+		try {
+			for (const value_type &v : other)
+				nodes[i++] = new_node(v);
+		} catch (...) {
+			while (i)
+				free_node(static_cast<node *>(nodes[--i]));
+			throw;
+		}
+
+		rb_build_sorted(&tree_, nodes.get(), other.size_);
+		size_ = other.size_;
+	}
+
+	rb_tree tree_;
+	size_type size_;
+	Compare comp_;
+	node_alloc alloc_;
+};
+
+} // namespace rb
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * batch insertion: rb_insert_batch() versus one rb_insert() per node
+ * for ascending, random and clustered keys
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct item {
+	struct rb_node node;
+	unsigned long key;
+};
+
+#define I(n)	((struct item *)n)
+
+static unsigned long compares;
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	compares++;
+	if (I(r)->key != I(l)->key)
+		return I(r)->key < I(l)->key ? -1 : 1;
+	return 0;
+}
+
+static unsigned long rnd()
+{
+	return (unsigned long)rand() << 31 ^ rand();
+}
+
+static void gen(struct item *items, unsigned long n, const char *mode)
+{
+	unsigned long i, base = 0;
+
+	for (i = 0; i < n; i++) {
+		if (mode[0] == 'a')
+			items[i].key = i;
+		else if (mode[0] == 'r')
+			items[i].key = rnd();
+		else {
+			// timestamps: mostly ascending with small jitter
+			base += rand() % 8;
+			items[i].key = base * 64 + rand() % 256;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	struct item *items = calloc(n, sizeof(*items));
+	struct rb_node **batch = calloc(n, sizeof(*batch));
+	const char *modes[] = { "ascending", "random", "clustered" };
+	struct rb_tree tree;
+	unsigned long i, c1, c2;
+	double t0, t1, t2;
+	int m;
+
+	if (!items || !batch)
+		return 1;
+
+	for (i = 0; i < n; i++)
+		batch[i] = &items[i].node;
+
+	for (m = 0; m < 3; m++) {
+		srand(1);
+		gen(items, n, modes[m]);
+
+		rb_init(&tree);
+		compares = 0;
+		t0 = now_ns();
+		for (i = 0; i < n; i++)
+			rb_insert(&tree, batch[i], cmp);
+		t1 = now_ns();
+		c1 = compares;
+
+		rb_init(&tree);
+		compares = 0;
+		rb_insert_batch(&tree, batch, n, cmp);
+		t2 = now_ns();
+		c2 = compares;
+
+		printf("%-10s n=%lu: rb_insert %.1f ns %.1f cmp, "
+			"rb_insert_batch %.1f ns %.1f cmp\n", modes[m], n,
+			(t1 - t0) / n, (double)c1 / n,
+			(t2 - t1) / n, (double)c2 / n);
+	}
+
+	free(items);
+	free(batch);
+	return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * one descent versus two: rb_floor() against rb_find() falling back to
+ * rb_prev_from(), and find-or-insert with rb_find_or_insert_pos()
+ * against rb_find() followed by rb_insert()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct bucket {
+	struct rb_node node;
+	unsigned long key;
+};
+
+#define B(n)	((struct bucket *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (B(r)->key != B(l)->key)
+		return B(r)->key < B(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	return (k > B(n)->key) - (k < B(n)->key);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long lookups = n * 2, i, found = 0;
+	struct bucket *b = calloc(n * 2, sizeof(*b));
+	unsigned long *keys = calloc(lookups, sizeof(*keys));
+	char *added = calloc(n, 1);
+	struct rb_node *node, *parent, **link;
+	struct rb_tree tree;
+	double t0, t1, t2;
+
+	if (!b || !keys || !added)
+		return 1;
+
+	srand(1);
+	rb_init(&tree);
+	for (i = 0; i < n; i++) {
+		b[i].key = (unsigned long)rand() << 31 ^ rand();
+		rb_insert(&tree, &b[i].node, cmp);
+	}
+	for (i = 0; i < lookups; i++)
+		keys[i] = i % 2 ? b[rand() % n].key : (unsigned long)rand() << 31;
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++) {
+		node = rb_find(&tree, &keys[i], find_cmp);
+		if (!node)
+			node = rb_prev_from(&tree, &keys[i], find_cmp);
+		found += !!node;
+	}
+	t1 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_floor(&tree, &keys[i], find_cmp);
+	t2 = now_ns();
+	printf("floor  n=%lu: find + prev_from %.1f ns, rb_floor %.1f ns\n",
+		n, (t1 - t0) / lookups, (t2 - t1) / lookups);
+
+	// half the keys are new, each new node is inserted once
+	t0 = now_ns();
+	for (i = 0; i < n; i++) {
+		b[n + i].key = keys[i];
+		if (!rb_find(&tree, &keys[i], find_cmp))
+			added[i] = rb_insert(&tree, &b[n + i].node, cmp);
+	}
+	t1 = now_ns();
+	for (i = 0; i < n; i++)
+		if (added[i])
+			rb_delete(&tree, &b[n + i].node);
+	t2 = now_ns();
+	for (i = 0; i < n; i++) {
+		if (rb_find_or_insert_pos(&tree, &keys[i], find_cmp,
+					&parent, &link))
+			continue;
+		rb_link_node(&b[n + i].node, parent, link);
+		rb_insert_color(&tree, &b[n + i].node);
+	}
+	printf("upsert n=%lu: find + insert %.1f ns, rb_find_or_insert_pos %.1f ns\n",
+		n, (t1 - t0) / n, (now_ns() - t2) / n);
+
+	fprintf(stderr, "%lu\n", found);
+	free(b);
+	free(keys);
+	free(added);
+	return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * timer tick path: peek the earliest node, pop it and re-arm it later,
+ * plain rb_tree versus rb_tree_cached
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct timer {
+	struct rb_node node;
+	unsigned long expires;
+};
+
+#define T(n)	((struct timer *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	// unique keys: break ties by address
+	if (T(r)->expires != T(l)->expires)
+		return T(r)->expires < T(l)->expires ? -1 : 1;
+	return r < l ? -1 : (r > l);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long ticks = argc > 2 ? strtoul(argv[2], NULL, 0) : 5000000;
+	struct timer *timers = calloc(n, sizeof(*timers));
+	struct rb_tree plain;
+	struct rb_tree_cached cached;
+	struct rb_node *node;
+	unsigned long i, sum = 0;
+	double t0, t1, t2;
+
+	if (!timers)
+		return 1;
+
+	srand(1);
+	rb_init(&plain);
+	for (i = 0; i < n; i++) {
+		timers[i].expires = ((unsigned long)rand() << 16) ^ rand();
+		rb_insert(&plain, &timers[i].node, cmp);
+	}
+
+	// peek only
+	t0 = now_ns();
+	for (i = 0; i < ticks; i++) {
+		sum += T(rb_first(&plain))->expires;
+		barrier();
+	}
+	t1 = now_ns();
+
+	rb_init_cached(&cached);
+	for (i = 0; i < n; i++)
+		rb_insert_cached(&cached, &timers[i].node, cmp);
+
+	t2 = now_ns();
+	for (i = 0; i < ticks; i++) {
+		sum += T(rb_first_cached(&cached))->expires;
+		barrier();
+	}
+	printf("peek      n=%lu: rb_first %.2f ns, rb_first_cached %.2f ns\n",
+		n, (t1 - t0) / ticks, (now_ns() - t2) / ticks);
+
+	// pop the earliest and re-arm it in the future
+	rb_init(&plain);
+	for (i = 0; i < n; i++)
+		rb_insert(&plain, &timers[i].node, cmp);
+
+	t0 = now_ns();
+	for (i = 0; i < ticks; i++) {
+		node = rb_first(&plain);
+		rb_delete(&plain, node);
+		T(node)->expires += n;
+		rb_insert(&plain, node, cmp);
+	}
+	t1 = now_ns();
+
+	rb_init_cached(&cached);
+	for (i = 0; i < n; i++)
+		rb_insert_cached(&cached, &timers[i].node, cmp);
+
+	t2 = now_ns();
+	for (i = 0; i < ticks; i++) {
+		node = rb_pop_first_cached(&cached);
+		T(node)->expires += n;
+		rb_insert_cached(&cached, node, cmp);
+	}
+	printf("pop+rearm n=%lu: rb_tree %.2f ns, rb_tree_cached %.2f ns\n",
+		n, (t1 - t0) / ticks, (now_ns() - t2) / ticks);
+
+	fprintf(stderr, "%lu\n", sum & 1);
+	free(timers);
+	return 0;
+}
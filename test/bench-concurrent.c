@@ -0,0 +1,146 @@
+/*
+ * read scaling: lockless rb_ctree_find() versus rb_find() under a
+ * mutex, with one writer thread inserting and deleting meanwhile
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../rbtree-concurrent.h"
+#include "check.h"
+
+struct item {
+	struct rb_node node;
+	unsigned long key;
+};
+
+#define I(n)	((struct item *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (I(r)->key != I(l)->key)
+		return I(r)->key < I(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int cmp_key(struct rb_node *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	if (k != I(n)->key)
+		return k < I(n)->key ? -1 : 1;
+	return 0;
+}
+
+static struct rb_ctree ctree;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct item *items;
+static unsigned long n;
+static int stop, locked;
+
+static void *reader(void *arg)
+{
+	unsigned int seed = (unsigned long)arg;
+	unsigned long lookups = 0, key;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		key = rand_r(&seed) % n * 2;
+		if (locked) {
+			pthread_mutex_lock(&lock);
+			rb_find(&ctree.tree, &key, cmp_key);
+			pthread_mutex_unlock(&lock);
+		}
+		else
+			rb_ctree_find(&ctree, &key, cmp_key);
+		lookups++;
+	}
+
+	return (void *)lookups;
+}
+
+// churn the odd keys, 1 write per 10us
+static void *writer(void *arg)
+{
+	struct item *extra = arg;
+	unsigned long i = 0;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		struct item *x = &extra[i++ % 1024];
+
+		if (locked) {
+			pthread_mutex_lock(&lock);
+			if (!rb_insert(&ctree.tree, &x->node, cmp))
+				rb_delete(&ctree.tree, &x->node);
+			pthread_mutex_unlock(&lock);
+		}
+		else if (!rb_ctree_insert(&ctree, &x->node, cmp))
+			rb_ctree_delete(&ctree, &x->node);
+		usleep(10);
+	}
+
+	return NULL;
+}
+
+static double run(int threads)
+{
+	pthread_t tids[threads], wtid;
+	struct item extra[1024];
+	unsigned long total = 0, i;
+	void *ret;
+	double t0;
+
+	for (i = 0; i < 1024; i++)
+		extra[i].key = (rand() % n) * 2 + 1;
+
+	stop = 0;
+	t0 = now_ns();
+	pthread_create(&wtid, NULL, writer, extra);
+	for (i = 0; i < (unsigned long)threads; i++)
+		pthread_create(&tids[i], NULL, reader, (void *)i);
+	usleep(500000);
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < (unsigned long)threads; i++) {
+		pthread_join(tids[i], &ret);
+		total += (unsigned long)ret;
+	}
+	pthread_join(wtid, NULL);
+
+	// leave the tree without the extra nodes
+	for (i = 0; i < 1024; i++)
+		if (rb_find(&ctree.tree, &extra[i].key, cmp_key) ==
+				&extra[i].node)
+			rb_delete(&ctree.tree, &extra[i].node);
+
+	return total / ((now_ns() - t0) / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+	int max = argc > 2 ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long i;
+	int threads;
+
+	n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	items = calloc(n, sizeof(*items));
+	if (!items)
+		return 1;
+
+	rb_ctree_init(&ctree);
+	for (i = 0; i < n; i++) {
+		items[i].key = i * 2;
+		rb_insert(&ctree.tree, &items[i].node, cmp);
+	}
+
+	for (threads = 1; threads <= max; threads++) {
+		locked = 1;
+		printf("%2d readers n=%lu: mutex %.2f Mlookup/s", threads, n,
+			run(threads) / 1e6);
+		locked = 0;
+		printf(", lockless %.2f Mlookup/s\n", run(threads) / 1e6);
+	}
+
+	rb_ctree_destroy(&ctree);
+	free(items);
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * lookups in a tree larger than the last level cache, batches of keys
+ * through rb_find_batch() versus one rb_find() per key
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct item {
+	struct rb_node node;
+	unsigned long key;
+};
+
+#define I(n)	((struct item *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (I(r)->key != I(l)->key)
+		return I(r)->key < I(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	return (k > I(n)->key) - (k < I(n)->key);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 4000000;
+	unsigned long lookups = 4000000, i, j, found = 0;
+	struct item *items = calloc(n, sizeof(*items));
+	unsigned long *values = calloc(lookups, sizeof(*values));
+	const void **keys = calloc(lookups, sizeof(*keys));
+	struct rb_node **out = calloc(lookups, sizeof(*out));
+	static const unsigned long sizes[] = { 4, 16, 64, 256 };
+	struct rb_tree tree;
+	double t0, t1;
+	int s;
+
+	if (!items || !values || !keys || !out)
+		return 1;
+
+	srand(1);
+	rb_init(&tree);
+	for (i = 0; i < n; i++) {
+		items[i].key = (unsigned long)rand() << 31 ^ rand();
+		rb_insert(&tree, &items[i].node, cmp);
+	}
+	for (i = 0; i < lookups; i++) {
+		values[i] = items[rand() % n].key;
+		keys[i] = &values[i];
+	}
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_find(&tree, keys[i], find_cmp);
+	t1 = now_ns();
+	printf("rb_find            n=%lu: %.1f ns/key, %.2f M keys/s\n", n,
+		(t1 - t0) / lookups, lookups / (t1 - t0) * 1e3);
+
+	for (s = 0; s < 4; s++) {
+		t0 = now_ns();
+		for (i = 0; i < lookups; i += sizes[s]) {
+			j = lookups - i < sizes[s] ? lookups - i : sizes[s];
+			rb_find_batch(&tree, keys + i, j, find_cmp, out + i);
+		}
+		t1 = now_ns();
+		for (i = 0; i < lookups; i++)
+			found += !!out[i];
+		printf("rb_find_batch %3lu  n=%lu: %.1f ns/key, %.2f M keys/s\n",
+			sizes[s], n, (t1 - t0) / lookups,
+			lookups / (t1 - t0) * 1e3);
+	}
+
+	fprintf(stderr, "%lu\n", found);
+	free(items);
+	free(values);
+	free(keys);
+	free(out);
+	return 0;
+}
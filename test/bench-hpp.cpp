@@ -0,0 +1,91 @@
+/*
+ * rb::map and rb::intrusive_set versus std::map, insert, lookup and
+ * erase of random int64 keys
+ */
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include "../rbtree.hpp"
+#include "check.h"
+
+struct item {
+	rb_node node;
+	int64_t key;
+};
+
+struct item_less {
+	typedef void is_transparent;
+
+	bool operator()(const item &a, const item &b) const { return a.key < b.key; }
+	bool operator()(const item &a, int64_t b) const { return a.key < b; }
+	bool operator()(int64_t a, const item &b) const { return a < b.key; }
+};
+
+template <class Map>
+static void run(const char *name, const std::vector<int64_t> &keys)
+{
+	size_t n = keys.size(), found = 0, i;
+	double t0, t1, t2, t3;
+	Map map;
+
+	t0 = now_ns();
+	for (i = 0; i < n; i++)
+		map.emplace(keys[i], i);
+	t1 = now_ns();
+	for (i = 0; i < n; i++)
+		found += map.find(keys[(i * 7) % n]) != map.end();
+	t2 = now_ns();
+	for (i = 0; i < n; i++)
+		map.erase(keys[i]);
+	t3 = now_ns();
+
+	printf("%-16s n=%zu: insert %.1f ns, find %.1f ns, erase %.1f ns\n",
+		name, n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n);
+	fprintf(stderr, "%zu\n", found);
+}
+
+static void run_set(const std::vector<int64_t> &keys)
+{
+	size_t n = keys.size(), found = 0, i;
+	std::vector<item> items(n);
+	rb::intrusive_set<item, &item::node, item_less> set;
+	double t0, t1, t2, t3;
+
+	for (i = 0; i < n; i++)
+		items[i].key = keys[i];
+
+	t0 = now_ns();
+	for (i = 0; i < n; i++)
+		set.insert(items[i]);
+	t1 = now_ns();
+	for (i = 0; i < n; i++)
+		found += set.find(keys[(i * 7) % n]) != set.end();
+	t2 = now_ns();
+	for (i = 0; i < n; i++)
+		set.erase(items[i]);
+	t3 = now_ns();
+
+	printf("%-16s n=%zu: insert %.1f ns, find %.1f ns, erase %.1f ns\n",
+		"rb::intrusive_set", n, (t1 - t0) / n, (t2 - t1) / n,
+		(t3 - t2) / n);
+	fprintf(stderr, "%zu\n", found);
+}
+
+int main(int argc, char **argv)
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000, i;
+	std::vector<int64_t> keys(n);
+
+	// distinct keys in random order
+	srand(1);
+	for (i = 0; i < n; i++)
+		keys[i] = (int64_t)i * 4 + 1;
+	for (i = n - 1; i > 0; i--)
+		std::swap(keys[i], keys[rand() % (i + 1)]);
+
+	run<std::map<int64_t, size_t>>("std::map", keys);
+	run<rb::map<int64_t, size_t>>("rb::map", keys);
+	run_set(keys);
+	return 0;
+}
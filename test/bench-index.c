@@ -0,0 +1,98 @@
+/*
+ * memory and lookup latency of a tree of small keys, nodes linked by
+ * pointers (struct rb_node) versus by 32 bit indices (struct rb_inode)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../rbtree-index.h"
+#include "check.h"
+
+struct pentry {
+	struct rb_node node;
+	uint32_t key;
+};
+
+struct ientry {
+	struct rb_inode node;
+	uint32_t key;
+};
+
+#define P(n)	((struct pentry *)n)
+
+static int pcmp(struct rb_node *l, struct rb_node *r)
+{
+	if (P(r)->key != P(l)->key)
+		return P(r)->key < P(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int pfind_cmp(struct rb_node *n, const void *key)
+{
+	uint32_t k = *(const uint32_t *)key;
+
+	return (k > P(n)->key) - (k < P(n)->key);
+}
+
+static int icmp(const struct rb_itree *tree, uint32_t a, uint32_t b)
+{
+	uint32_t ka = ((struct ientry *)rb_inode(tree, a))->key;
+	uint32_t kb = ((struct ientry *)rb_inode(tree, b))->key;
+
+	return (kb > ka) - (kb < ka);
+}
+
+static int ifind_cmp(const struct rb_itree *tree, uint32_t i, const void *key)
+{
+	uint32_t k = *(const uint32_t *)key;
+	uint32_t v = ((struct ientry *)rb_inode(tree, i))->key;
+
+	return (k > v) - (k < v);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 4000000;
+	unsigned long lookups = 4000000, i, found = 0;
+	struct pentry *pe = calloc(n, sizeof(*pe));
+	struct ientry *ie = calloc(n + 1, sizeof(*ie));	// element 0 unused
+	uint32_t *keys = calloc(lookups, sizeof(*keys));
+	struct rb_tree pt;
+	struct rb_itree it;
+	double t0, t1, t2;
+
+	if (!pe || !ie || !keys)
+		return 1;
+
+	srand(1);
+	rb_init(&pt);
+	rb_itree_init(&it, ie, sizeof(*ie), 0);
+	for (i = 0; i < n; i++) {
+		pe[i].key = ie[i + 1].key = (uint32_t)rand() << 1 ^ rand();
+		rb_insert(&pt, &pe[i].node, pcmp);
+		rb_itree_insert(&it, i + 1, icmp);
+	}
+	for (i = 0; i < lookups; i++)
+		keys[i] = pe[rand() % n].key;
+
+	printf("n=%lu: pointer %zu bytes/entry %.1f MB, index %zu bytes/entry %.1f MB\n",
+		n, sizeof(*pe), n * sizeof(*pe) / 1e6, sizeof(*ie),
+		(n + 1) * sizeof(*ie) / 1e6);
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_find(&pt, &keys[i], pfind_cmp);
+	t1 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_itree_find(&it, &keys[i], ifind_cmp);
+	t2 = now_ns();
+	printf("lookup: pointer %.1f ns, index %.1f ns\n",
+		(t1 - t0) / lookups, (t2 - t1) / lookups);
+
+	fprintf(stderr, "%lu\n", found);
+	free(pe);
+	free(ie);
+	free(keys);
+	return 0;
+}
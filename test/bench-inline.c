@@ -0,0 +1,97 @@
+/*
+ * lookups with the comparator inlined by RB_DECLARE_TREE() versus
+ * rb_find() calling it through a pointer, for int64 and string keys
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../rbtree-inline.h"
+#include "check.h"
+
+struct inode {
+	struct rb_node node;
+	int64_t key;
+};
+
+struct snode {
+	struct rb_node node;
+	const char *key;
+};
+
+#define ikey(x) ((x)->key)
+#define icmp(a, b) (((a) > (b)) - ((a) < (b)))
+#define skey(x) ((x)->key)
+#define scmp(a, b) strcmp(a, b)
+
+RB_DECLARE_TREE(itree, struct inode, node, int64_t, ikey, icmp)
+RB_DECLARE_TREE(stree, struct snode, node, const char *, skey, scmp)
+
+static int ifind_cmp(struct rb_node *n, const void *key)
+{
+	int64_t k = *(const int64_t *)key;
+	int64_t v = rb_entry(n, struct inode, node)->key;
+
+	return (k > v) - (k < v);
+}
+
+static int sfind_cmp(struct rb_node *n, const void *key)
+{
+	return strcmp(key, rb_entry(n, struct snode, node)->key);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long lookups = n * 4, i;
+	struct inode *inodes = calloc(n, sizeof(*inodes));
+	struct snode *snodes = calloc(n, sizeof(*snodes));
+	char *strs = calloc(n, 24);
+	int64_t *ikeys = calloc(lookups, sizeof(*ikeys));
+	const char **skeys = calloc(lookups, sizeof(*skeys));
+	struct rb_tree it, st;
+	unsigned long found = 0;
+	double t0, t1, t2;
+
+	if (!inodes || !snodes || !strs || !ikeys || !skeys)
+		return 1;
+
+	srand(1);
+	rb_init(&it);
+	rb_init(&st);
+	for (i = 0; i < n; i++) {
+		inodes[i].key = (int64_t)rand() << 31 ^ rand();
+		itree_insert(&it, &inodes[i]);
+		snprintf(strs + i * 24, 24, "session-%014lx", (unsigned long)rand());
+		snodes[i].key = strs + i * 24;
+		stree_insert(&st, &snodes[i]);
+	}
+	for (i = 0; i < lookups; i++) {
+		ikeys[i] = inodes[rand() % n].key;
+		skeys[i] = snodes[rand() % n].key;
+	}
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_find(&it, &ikeys[i], ifind_cmp);
+	t1 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!itree_find(&it, ikeys[i]);
+	t2 = now_ns();
+	printf("int64  n=%lu: rb_find %.1f ns, inlined %.1f ns\n", n,
+		(t1 - t0) / lookups, (t2 - t1) / lookups);
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_find(&st, skeys[i], sfind_cmp);
+	t1 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!stree_find(&st, skeys[i]);
+	t2 = now_ns();
+	printf("string n=%lu: rb_find %.1f ns, inlined %.1f ns\n", n,
+		(t1 - t0) / lookups, (t2 - t1) / lookups);
+
+	fprintf(stderr, "%lu\n", found);
+	return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * overlap queries: interval tree versus scanning forward in start order
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree-interval.h"
+#include "check.h"
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long queries = argc > 2 ? strtoul(argv[2], NULL, 0) : 1000;
+	unsigned long range = n * 16;
+	struct rb_interval_node *nodes = calloc(n, sizeof(*nodes));
+	struct rb_interval_node *it;
+	struct rb_tree tree;
+	struct rb_node *node;
+	unsigned long i, s, found1 = 0, found2 = 0;
+	double t0, t1, t2;
+
+	if (!nodes)
+		return 1;
+
+	srand(1);
+	rb_init(&tree);
+	for (i = 0; i < n; i++) {
+		nodes[i].start = ((unsigned long)rand() << 16 ^ rand()) % range;
+		// 1 in 1000 intervals is long
+		nodes[i].last = nodes[i].start + (i % 1000 ?
+			(unsigned long)(rand() % 64) :
+			(unsigned long)rand() % range);
+		rb_interval_insert(&tree, &nodes[i]);
+	}
+
+	srand(2);
+	t0 = now_ns();
+	for (i = 0; i < queries; i++) {
+		s = ((unsigned long)rand() << 16 ^ rand()) % range;
+		// without the augmented data any interval starting before
+		// the query may overlap it
+		rb_for_each(node, &tree) {
+			it = rb_interval_entry(node);
+			if (it->start > s + 100)
+				break;
+			if (s <= it->last)
+				found1++;
+		}
+	}
+	t1 = now_ns();
+
+	srand(2);
+	for (i = 0; i < queries; i++) {
+		s = ((unsigned long)rand() << 16 ^ rand()) % range;
+		rb_interval_for_each(it, &tree, s, s + 100)
+			found2++;
+	}
+	t2 = now_ns();
+
+	printf("overlap n=%lu: scan %.0f ns/query, interval tree %.0f ns/query "
+		"(%.1f hits/query)\n", n, (t1 - t0) / queries,
+		(t2 - t1) / queries, (double)found2 / queries);
+
+	free(nodes);
+	return found1 != found2;
+}
@@ -0,0 +1,78 @@
+/*
+ * event queue with many equal timestamps: rb_insert() with a sequence
+ * number tiebreaker versus rb_insert_multi() on the timestamp alone
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct event {
+	struct rb_node node;
+	unsigned long ts;
+	unsigned long seq;
+};
+
+#define E(n)	((struct event *)n)
+
+static unsigned long compares;
+
+static int cmp_seq(struct rb_node *l, struct rb_node *r)
+{
+	compares++;
+	if (E(r)->ts != E(l)->ts)
+		return E(r)->ts < E(l)->ts ? -1 : 1;
+	if (E(r)->seq != E(l)->seq)
+		return E(r)->seq < E(l)->seq ? -1 : 1;
+	return 0;
+}
+
+static int cmp_ts(struct rb_node *l, struct rb_node *r)
+{
+	compares++;
+	if (E(r)->ts != E(l)->ts)
+		return E(r)->ts < E(l)->ts ? -1 : 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long distinct = argc > 2 ? strtoul(argv[2], NULL, 0) : 1000;
+	struct event *ev = calloc(n, sizeof(*ev));
+	struct rb_tree tree;
+	unsigned long i, c1;
+	double t0, t1, t2;
+
+	if (!ev || !distinct)
+		return 1;
+
+	srand(1);
+	for (i = 0; i < n; i++) {
+		ev[i].ts = rand() % distinct;
+		ev[i].seq = i;
+	}
+
+	rb_init(&tree);
+	compares = 0;
+	t0 = now_ns();
+	for (i = 0; i < n; i++)
+		rb_insert(&tree, &ev[i].node, cmp_seq);
+	t1 = now_ns();
+	c1 = compares;
+
+	rb_init(&tree);
+	compares = 0;
+	t2 = now_ns();
+	for (i = 0; i < n; i++)
+		rb_insert_multi(&tree, &ev[i].node, cmp_ts);
+
+	printf("n=%lu, %lu timestamps: rb_insert + seq %.1f ns %.1f cmp, "
+		"rb_insert_multi %.1f ns %.1f cmp\n", n, distinct,
+		(t1 - t0) / n, (double)c1 / n,
+		(now_ns() - t2) / n, (double)compares / n);
+
+	free(ev);
+	return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * percentile queries: rb_select() versus walking rb_next() from rb_first()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree-order.h"
+#include "check.h"
+
+struct sample {
+	struct rb_order_node node;
+	unsigned long latency;
+};
+
+#define S(n)	((struct sample *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (S(r)->latency != S(l)->latency)
+		return S(r)->latency < S(l)->latency ? -1 : 1;
+	return r < l ? -1 : (r > l);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000000;
+	unsigned long queries = argc > 2 ? strtoul(argv[2], NULL, 0) : 10;
+	struct sample *samples = calloc(n, sizeof(*samples));
+	struct rb_tree tree;
+	struct rb_node *node;
+	unsigned long i, j, k, sum = 0;
+	double t0, t1, t2;
+
+	if (!samples)
+		return 1;
+
+	srand(1);
+	rb_init(&tree);
+	t0 = now_ns();
+	for (i = 0; i < n; i++) {
+		samples[i].latency = ((unsigned long)rand() << 16) ^ rand();
+		rb_order_insert(&tree, &samples[i].node, cmp);
+	}
+	printf("build n=%lu: %.1f ns/insert\n", n, (now_ns() - t0) / n);
+
+	k = n / 100 * 99;
+
+	t0 = now_ns();
+	for (i = 0; i < queries; i++) {
+		node = rb_first(&tree);
+		for (j = 0; j < k; j++)
+			node = rb_next(node);
+		sum += S(node)->latency;
+	}
+	t1 = now_ns();
+
+	for (i = 0; i < queries * 100000; i++) {
+		// within [0, k] also when the tree is small
+		sum += S(rb_select(&tree, k - (i % 1000) % (k + 1)))->latency;
+		barrier();
+	}
+	t2 = now_ns();
+
+	printf("p99 n=%lu: linear %.0f ns/query, rb_select %.0f ns/query\n",
+		n, (t1 - t0) / queries, (t2 - t1) / (queries * 100000));
+
+	t0 = now_ns();
+	for (i = 0; i < queries * 100000; i++) {
+		sum += rb_rank(&tree, &samples[i % n].node.node);
+		barrier();
+	}
+	printf("rank n=%lu: rb_rank %.0f ns/query\n",
+		n, (now_ns() - t0) / (queries * 100000));
+
+	fprintf(stderr, "%lu\n", sum & 1);
+	free(samples);
+	return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * building, walking and destroying a tree of n nodes, each node from
+ * malloc() versus from an rb_pool, with and without huge pages
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree-pool.h"
+#include "check.h"
+
+struct entry {
+	struct rb_node node;
+	unsigned long key;
+	unsigned long value;
+};
+
+#define E(n)	((struct entry *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (E(r)->key != E(l)->key)
+		return E(r)->key < E(l)->key ? -1 : 1;
+	return 0;
+}
+
+static void report(const char *name, unsigned long n, double t0, double t1,
+		double t2, double t3, unsigned long sum)
+{
+	printf("%-10s n=%lu: insert %.1f ns, walk %.1f ns, destroy %.1f ms\n",
+		name, n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / 1e6);
+	fprintf(stderr, "%lu\n", sum);
+}
+
+static void run_malloc(unsigned long *keys, unsigned long n)
+{
+	struct rb_tree tree;
+	struct rb_node *node, *next;
+	struct entry *e;
+	unsigned long i, sum = 0;
+	double t0, t1, t2, t3;
+
+	rb_init(&tree);
+	t0 = now_ns();
+	for (i = 0; i < n; i++) {
+		e = malloc(sizeof(*e));
+		e->key = keys[i];
+		rb_insert(&tree, &e->node, cmp);
+	}
+	t1 = now_ns();
+	rb_for_each(node, &tree)
+		sum += E(node)->key;
+	t2 = now_ns();
+	for (node = rb_first_postorder(&tree); node; node = next) {
+		next = rb_next_postorder(node);
+		free(node);
+	}
+	rb_init(&tree);
+	t3 = now_ns();
+	report("malloc", n, t0, t1, t2, t3, sum);
+}
+
+static void run_pool(const char *name, int flags, unsigned long *keys,
+		unsigned long n)
+{
+	struct rb_pool pool;
+	struct rb_tree tree;
+	struct rb_node *node;
+	struct entry *e;
+	unsigned long i, sum = 0;
+	double t0, t1, t2, t3;
+
+	rb_pool_init(&pool, sizeof(*e), 0, flags);
+	rb_init(&tree);
+	t0 = now_ns();
+	for (i = 0; i < n; i++) {
+		e = rb_pool_alloc(&pool);
+		e->key = keys[i];
+		rb_insert(&tree, &e->node, cmp);
+	}
+	t1 = now_ns();
+	rb_for_each(node, &tree)
+		sum += E(node)->key;
+	t2 = now_ns();
+	rb_destroy(&tree, &pool);
+	t3 = now_ns();
+	report(name, n, t0, t1, t2, t3, sum);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long *keys = calloc(n, sizeof(*keys));
+	unsigned long i;
+
+	if (!keys)
+		return 1;
+
+	srand(1);
+	for (i = 0; i < n; i++)
+		keys[i] = (unsigned long)rand() << 31 ^ rand();
+
+	run_malloc(keys, n);
+	run_pool("pool", 0, keys, n);
+	run_pool("pool huge", RB_POOL_HUGEPAGE, keys, n);
+
+	free(keys);
+	return 0;
+}
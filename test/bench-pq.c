@@ -0,0 +1,296 @@
+/*
+ * timer queue workloads on rb_pq against rb_first() + rb_delete(), a
+ * binary heap and a pairing heap:
+ *   hold: pop the earliest timer and rearm it a random delay later
+ *   decrease: hold, plus moving a random timer earlier each round
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree-pq.h"
+#include "check.h"
+
+struct timer {
+	struct rb_node node;
+	unsigned long expires;
+	size_t idx;				// binary heap slot
+	struct timer *child, *next, *prev;	// pairing heap, prev is
+						// the parent for a first child
+};
+
+#define T(n)	((struct timer *)n)
+
+#define DELAY	100000
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (T(r)->expires != T(l)->expires)
+		return T(r)->expires < T(l)->expires ? -1 : 1;
+	return 0;
+}
+
+// binary heap
+
+static struct timer **heap;
+static size_t heap_n;
+
+static void heap_up(size_t i)
+{
+	struct timer *t = heap[i];
+
+	while (i) {
+		size_t p = (i - 1) / 2;
+
+		if (heap[p]->expires <= t->expires)
+			break;
+		heap[i] = heap[p];
+		heap[i]->idx = i;
+		i = p;
+	}
+	heap[i] = t;
+	t->idx = i;
+}
+
+static void heap_down(size_t i)
+{
+	struct timer *t = heap[i];
+	size_t c;
+
+	while ((c = i * 2 + 1) < heap_n) {
+		if (c + 1 < heap_n && heap[c + 1]->expires < heap[c]->expires)
+			c++;
+		if (t->expires <= heap[c]->expires)
+			break;
+		heap[i] = heap[c];
+		heap[i]->idx = i;
+		i = c;
+	}
+	heap[i] = t;
+	t->idx = i;
+}
+
+static void heap_push(struct timer *t)
+{
+	heap[heap_n++] = t;
+	heap_up(heap_n - 1);
+}
+
+static struct timer *heap_pop(void)
+{
+	struct timer *t = heap[0];
+
+	heap[0] = heap[--heap_n];
+	if (heap_n)
+		heap_down(0);
+	return t;
+}
+
+// pairing heap
+
+static struct timer *ph_root;
+
+static struct timer *ph_meld(struct timer *a, struct timer *b)
+{
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+	if (b->expires < a->expires) {
+		struct timer *t = a;
+
+		a = b;
+		b = t;
+	}
+	b->next = a->child;
+	if (a->child)
+		a->child->prev = b;
+	b->prev = a;
+	a->child = b;
+	a->next = a->prev = NULL;
+	return a;
+}
+
+static void ph_push(struct timer *t)
+{
+	t->child = t->next = t->prev = NULL;
+	ph_root = ph_meld(ph_root, t);
+}
+
+// meld pairs left to right, then the pairs right to left
+static struct timer *ph_merge_pairs(struct timer *first)
+{
+	struct timer *pairs = NULL, *a, *b, *h;
+
+	while (first) {
+		a = first;
+		b = a->next;
+		first = b ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b)
+			b->next = b->prev = NULL;
+		h = ph_meld(a, b);
+		h->next = pairs;
+		pairs = h;
+	}
+
+	h = NULL;
+	while (pairs) {
+		a = pairs;
+		pairs = a->next;
+		a->next = NULL;
+		h = ph_meld(h, a);
+	}
+	return h;
+}
+
+static struct timer *ph_pop(void)
+{
+	struct timer *t = ph_root;
+
+	ph_root = ph_merge_pairs(t->child);
+	return t;
+}
+
+static void ph_decrease(struct timer *t)
+{
+	if (t == ph_root)
+		return;
+
+	// cut t with its subtree and meld it back at the root
+	if (t->prev->child == t)
+		t->prev->child = t->next;
+	else
+		t->prev->next = t->next;
+	if (t->next)
+		t->next->prev = t->prev;
+	t->next = t->prev = NULL;
+	ph_root = ph_meld(ph_root, t);
+}
+
+static void setup(struct timer *timers, unsigned long n)
+{
+	unsigned long i;
+
+	srand(2);
+	for (i = 0; i < n; i++)
+		timers[i].expires = rand() % DELAY;
+}
+
+// move t halfway to now, the earliest expiry, NULL if it can't move
+static struct timer *decrease(struct timer *t, unsigned long now)
+{
+	if (t->expires <= now + 1)
+		return NULL;
+	t->expires -= (t->expires - now) / 2;
+	return t;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long rounds = n * 2, i, sum = 0;
+	struct timer *timers = calloc(n, sizeof(*timers));
+	unsigned long *delays = calloc(rounds, sizeof(*delays));
+	size_t *victims = calloc(rounds, sizeof(*victims));
+	struct rb_tree tree;
+	struct rb_pq pq;
+	struct rb_node *node;
+	struct timer *t;
+	double t0, res[2][4];
+	int w;
+
+	heap = calloc(n, sizeof(*heap));
+	if (!timers || !delays || !victims || !heap)
+		return 1;
+
+	srand(1);
+	for (i = 0; i < rounds; i++) {
+		delays[i] = rand() % DELAY + 1;
+		victims[i] = rand() % n;
+	}
+
+	for (w = 0; w < 2; w++) {
+		setup(timers, n);
+		rb_init(&tree);
+		for (i = 0; i < n; i++)
+			rb_insert_multi(&tree, &timers[i].node, cmp);
+		t0 = now_ns();
+		for (i = 0; i < rounds; i++) {
+			node = rb_first(&tree);
+			rb_delete(&tree, node);
+			T(node)->expires += delays[i];
+			sum += T(node)->expires;
+			rb_insert_multi(&tree, node, cmp);
+			if (!w || !(t = decrease(&timers[victims[i]],
+					T(rb_first(&tree))->expires)))
+				continue;
+			rb_delete(&tree, &t->node);
+			rb_insert_multi(&tree, &t->node, cmp);
+		}
+		res[w][0] = (now_ns() - t0) / rounds;
+
+		setup(timers, n);
+		rb_pq_init(&pq, cmp);
+		for (i = 0; i < n; i++)
+			rb_pq_insert(&pq, &timers[i].node);
+		t0 = now_ns();
+		for (i = 0; i < rounds; i++) {
+			node = rb_pq_pop_min(&pq);
+			T(node)->expires += delays[i];
+			sum += T(node)->expires;
+			rb_pq_insert(&pq, node);
+			if (!w || !(t = decrease(&timers[victims[i]],
+					T(rb_pq_peek(&pq))->expires)))
+				continue;
+			rb_pq_decrease_key(&pq, &t->node);
+		}
+		res[w][1] = (now_ns() - t0) / rounds;
+
+		setup(timers, n);
+		heap_n = 0;
+		for (i = 0; i < n; i++)
+			heap_push(&timers[i]);
+		t0 = now_ns();
+		for (i = 0; i < rounds; i++) {
+			t = heap_pop();
+			t->expires += delays[i];
+			sum += t->expires;
+			heap_push(t);
+			if (!w || !(t = decrease(&timers[victims[i]],
+					heap[0]->expires)))
+				continue;
+			heap_up(t->idx);
+		}
+		res[w][2] = (now_ns() - t0) / rounds;
+
+		setup(timers, n);
+		ph_root = NULL;
+		for (i = 0; i < n; i++)
+			ph_push(&timers[i]);
+		t0 = now_ns();
+		for (i = 0; i < rounds; i++) {
+			t = ph_pop();
+			t->expires += delays[i];
+			sum += t->expires;
+			ph_push(t);
+			if (!w || !(t = decrease(&timers[victims[i]],
+					ph_root->expires)))
+				continue;
+			ph_decrease(t);
+		}
+		res[w][3] = (now_ns() - t0) / rounds;
+	}
+
+	for (w = 0; w < 2; w++)
+		printf("%-8s n=%lu: rb_first + rb_delete %.1f ns, rb_pq %.1f ns, "
+			"binary heap %.1f ns, pairing heap %.1f ns\n",
+			w ? "decrease" : "hold", n, res[w][0], res[w][1],
+			res[w][2], res[w][3]);
+
+	fprintf(stderr, "%lu\n", sum);
+	free(timers);
+	free(delays);
+	free(victims);
+	free(heap);
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * deleting key ranges [lo, hi) of different sizes: find the first node
+ * and rb_next() + rb_delete() each one, versus rb_delete_range()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct item {
+	struct rb_node node;
+	unsigned long key;
+};
+
+#define I(n)	((struct item *)n)
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	return (k > I(n)->key) - (k < I(n)->key);
+}
+
+static void build(struct rb_tree *tree, struct item *items,
+		struct rb_node **sorted, unsigned long n)
+{
+	unsigned long i;
+
+	for (i = 0; i < n; i++) {
+		items[i].key = i;
+		sorted[i] = &items[i].node;
+	}
+	rb_build_sorted(tree, sorted, n);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	static const unsigned long sizes[] = { 8, 32, 1000, 100000 };
+	struct item *items = calloc(n, sizeof(*items));
+	struct rb_node **sorted = calloc(n, sizeof(*sorted));
+	struct rb_node *node, *next;
+	struct rb_tree tree;
+	unsigned long r, rounds, lo, hi, k;
+	double t0, t1, t2, t3;
+	int s;
+
+	if (!items || !sorted)
+		return 1;
+
+	for (s = 0; s < 4; s++) {
+		k = sizes[s];
+		rounds = n / k / 2 < 1000 ? n / k / 2 : 1000;
+		if (!rounds)
+			continue;
+
+		// disjoint ranges spread over the tree
+		build(&tree, items, sorted, n);
+		t0 = now_ns();
+		for (r = 0; r < rounds; r++) {
+			lo = r * (n / rounds);
+			hi = lo + k;
+			node = rb_find(&tree, &lo, find_cmp);
+			while (node && I(node)->key < hi) {
+				next = rb_next(node);
+				rb_delete(&tree, node);
+				node = next;
+			}
+		}
+		t1 = now_ns();
+
+		build(&tree, items, sorted, n);
+		t2 = now_ns();
+		for (r = 0; r < rounds; r++) {
+			lo = r * (n / rounds);
+			hi = lo + k;
+			rb_delete_range(&tree, &lo, &hi, find_cmp, NULL);
+		}
+		t3 = now_ns();
+
+		printf("range %6lu n=%lu: per node %.1f us, rb_delete_range %.1f us\n",
+			k, n, (t1 - t0) / rounds / 1e3, (t3 - t2) / rounds / 1e3);
+	}
+
+	free(items);
+	free(sorted);
+	return 0;
+}
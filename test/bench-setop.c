@@ -0,0 +1,98 @@
+/*
+ * union of two large trees with 1 to N threads, versus a merge walk
+ * with rb_next() and rebuilding the result with rb_build_sorted()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../rbtree-setop.h"
+#include "check.h"
+
+struct route {
+	struct rb_node node;
+	unsigned long prefix;
+};
+
+#define R(n)	((struct route *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (R(r)->prefix != R(l)->prefix)
+		return R(r)->prefix < R(l)->prefix ? -1 : 1;
+	return 0;
+}
+
+// every other key of each half overlaps
+static void build(struct rb_tree *tree, struct route *routes,
+		struct rb_node **sorted, unsigned long n, int which)
+{
+	unsigned long i;
+
+	for (i = 0; i < n; i++) {
+		routes[i].prefix = i * 3 + (which && i % 2 ? 1 : 0);
+		sorted[i] = &routes[i].node;
+	}
+	rb_build_sorted(tree, sorted, n);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 2000000;
+	int max = argc > 2 ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+	struct route *a = calloc(n, sizeof(*a)), *b = calloc(n, sizeof(*b));
+	struct rb_node **sorted = calloc(n, sizeof(*sorted));
+	struct rb_node **merged = calloc(n * 2, sizeof(*merged));
+	struct rb_node *x, *y;
+	struct rb_threads pool;
+	struct rb_tree t1, t2, out;
+	double t0, t1ns;
+	unsigned long m;
+	int threads;
+
+	if (!a || !b || !sorted || !merged)
+		return 1;
+
+	// single threaded merge walk
+	build(&t1, a, sorted, n, 0);
+	build(&t2, b, sorted, n, 1);
+	t0 = now_ns();
+	x = rb_first(&t1);
+	y = rb_first(&t2);
+	m = 0;
+	while (x || y) {
+		if (!y || (x && R(x)->prefix <= R(y)->prefix)) {
+			if (y && R(x)->prefix == R(y)->prefix)
+				y = rb_next(y);
+			merged[m++] = x;
+			x = rb_next(x);
+		}
+		else {
+			merged[m++] = y;
+			y = rb_next(y);
+		}
+	}
+	rb_build_sorted(&out, merged, m);
+	printf("merge walk     n=2x%lu: %.1f ms\n", n, (now_ns() - t0) / 1e6);
+
+	for (threads = 1; threads <= max; threads++) {
+		build(&t1, a, sorted, n, 0);
+		build(&t2, b, sorted, n, 1);
+		if (rb_threads_init(&pool, threads - 1))
+			return 1;
+
+		t0 = now_ns();
+		rb_union(&t1, &t2, cmp, NULL, &pool);
+		t1ns = now_ns();
+		printf("rb_union %2d threads n=2x%lu: %.1f ms\n", threads, n,
+			(t1ns - t0) / 1e6);
+
+		rb_threads_destroy(&pool);
+	}
+
+	free(a);
+	free(b);
+	free(sorted);
+	free(merged);
+	return 0;
+}
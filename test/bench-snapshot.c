@@ -0,0 +1,106 @@
+/*
+ * lookups in a live rb_tree versus a frozen rb_snapshot of it, exact
+ * match with rb_find() and successor with rb_next_from(), then the
+ * snapshot lower bound with each block search
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../rbtree-snapshot.h"
+#include "check.h"
+
+struct entry {
+	struct rb_node node;
+	uint64_t key;
+};
+
+#define E(n)	((struct entry *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (E(r)->key != E(l)->key)
+		return E(r)->key < E(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	uint64_t k = *(const uint64_t *)key;
+
+	return (k > E(n)->key) - (k < E(n)->key);
+}
+
+static uint64_t key(struct rb_node *n)
+{
+	return E(n)->key;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000000;
+	unsigned long lookups = 4000000, i, found = 0;
+	struct entry *e = calloc(n, sizeof(*e));
+	uint64_t *keys = calloc(lookups, sizeof(*keys));
+	struct rb_snapshot snap;
+	struct rb_tree tree;
+	double t0, t1, t2;
+	static const char *isa_names[] = { "scalar", "sse4.2", "avx2" };
+	int isa;
+
+	if (!e || !keys)
+		return 1;
+
+	srand(1);
+	rb_init(&tree);
+	for (i = 0; i < n; i++) {
+		e[i].key = (uint64_t)rand() << 31 ^ rand();
+		rb_insert(&tree, &e[i].node, cmp);
+	}
+	for (i = 0; i < lookups; i++)
+		keys[i] = i % 2 ? e[rand() % n].key : (uint64_t)rand() << 31;
+
+	t0 = now_ns();
+	if (rb_snapshot_build(&snap, &tree, key))
+		return 1;
+	t1 = now_ns();
+	printf("build n=%lu: %.1f ms, %d levels\n", n, (t1 - t0) / 1e6,
+		snap.levels);
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_find(&tree, &keys[i], find_cmp);
+	t1 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_snapshot_find(&snap, keys[i]);
+	t2 = now_ns();
+	printf("find:      rb_find %.1f ns, snapshot %.1f ns\n",
+		(t1 - t0) / lookups, (t2 - t1) / lookups);
+
+	t0 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_next_from(&tree, &keys[i], find_cmp);
+	t1 = now_ns();
+	for (i = 0; i < lookups; i++)
+		found += !!rb_snapshot_next_from(&snap, keys[i]);
+	t2 = now_ns();
+	printf("next_from: rb_next_from %.1f ns, snapshot %.1f ns\n",
+		(t1 - t0) / lookups, (t2 - t1) / lookups);
+
+	for (isa = RB_SNAPSHOT_SCALAR; isa <= RB_SNAPSHOT_AVX2; isa++) {
+		if (rb_snapshot_use(&snap, isa))
+			continue;
+		t0 = now_ns();
+		for (i = 0; i < lookups; i++)
+			found += rb_snapshot_lower_bound(&snap, keys[i]);
+		t1 = now_ns();
+		printf("lower_bound %-6s: %.1f ns\n", isa_names[isa],
+			(t1 - t0) / lookups);
+	}
+
+	fprintf(stderr, "%lu\n", found);
+	rb_snapshot_destroy(&snap);
+	free(e);
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * timer service: 1M connections with a 30s idle timeout, 10k rearms per
+ * second from traffic, and an expired connection rearmed as a new one.
+ * ticks are ms, all timers in one rb_pq versus rb_timer with ~1s slots
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree-timer.h"
+#include "check.h"
+
+#define TIMEOUT		30000
+#define SHIFT		10
+
+struct conn {
+	struct rb_timer timer;
+};
+
+static unsigned long now;
+static struct rb_timer_base base;
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	struct rb_timer *a = rb_entry(l, struct rb_timer, node);
+	struct rb_timer *b = rb_entry(r, struct rb_timer, node);
+
+	if (b->expires != a->expires)
+		return b->expires < a->expires ? -1 : 1;
+	return 0;
+}
+
+// the connection is closed and a new one takes its place
+static void expired(struct rb_timer *t)
+{
+	rb_timer_arm(&base, t, now + TIMEOUT);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long secs = argc > 2 ? strtoul(argv[2], NULL, 0) : 60;
+	unsigned long rate = argc > 3 ? strtoul(argv[3], NULL, 0) : 10000;
+	unsigned long ticks = secs * 1000, per_tick = rate / 1000;
+	unsigned long i, k, start, expirations[2];
+	struct conn *conns = calloc(n, sizeof(*conns));
+	unsigned long *victims = calloc(ticks * per_tick, sizeof(*victims));
+	struct rb_node *node;
+	struct rb_pq pq;
+	struct rb_timer *t;
+	double t0, t1, arm[2] = { 0 }, expire[2] = { 0 };
+
+	if (!conns || !victims)
+		return 1;
+
+	srand(1);
+	for (i = 0; i < ticks * per_tick; i++)
+		victims[i] = rand() % n;
+
+	// all in one tree
+	start = now = 1000000;
+	rb_pq_init(&pq, cmp);
+	srand(2);
+	for (i = 0; i < n; i++) {
+		conns[i].timer.expires = now + rand() % TIMEOUT;
+		rb_pq_insert(&pq, &conns[i].timer.node);
+	}
+	expirations[0] = 0;
+	for (k = 0; k < ticks; k++) {
+		now++;
+		t0 = now_ns();
+		for (i = k * per_tick; i < (k + 1) * per_tick; i++) {
+			t = &conns[victims[i]].timer;
+			rb_pq_delete(&pq, &t->node);
+			t->expires = now + TIMEOUT;
+			rb_pq_insert(&pq, &t->node);
+		}
+		t1 = now_ns();
+		while ((node = rb_pq_peek(&pq)) &&
+				rb_entry(node, struct rb_timer, node)->expires <= now) {
+			rb_pq_pop_min(&pq);
+			t = rb_entry(node, struct rb_timer, node);
+			t->expires = now + TIMEOUT;
+			rb_pq_insert(&pq, &t->node);
+			expirations[0]++;
+		}
+		arm[0] += t1 - t0;
+		expire[0] += now_ns() - t1;
+	}
+
+	// near timers in the tree, far ones in the wheel
+	now = start;
+	rb_timer_base_init(&base, now, SHIFT);
+	srand(2);
+	for (i = 0; i < n; i++) {
+		rb_timer_init(&conns[i].timer, expired);
+		rb_timer_arm(&base, &conns[i].timer, now + rand() % TIMEOUT);
+	}
+	expirations[1] = 0;
+	for (k = 0; k < ticks; k++) {
+		now++;
+		t0 = now_ns();
+		for (i = k * per_tick; i < (k + 1) * per_tick; i++)
+			rb_timer_arm(&base, &conns[victims[i]].timer,
+					now + TIMEOUT);
+		t1 = now_ns();
+		expirations[1] += rb_timer_expire(&base, now);
+		arm[1] += t1 - t0;
+		expire[1] += now_ns() - t1;
+	}
+
+	for (i = 0; i < 2; i++)
+		printf("%-8s n=%lu %lus: rearm %.1f ns, expire %.1f ns per timer, "
+			"%.2f s total\n", i ? "rb_timer" : "rb_pq", n, secs,
+			arm[i] / (ticks * per_tick), expire[i] / expirations[i],
+			(arm[i] + expire[i]) / 1e9);
+
+	fprintf(stderr, "%lu %lu\n", expirations[0], expirations[1]);
+	free(conns);
+	free(victims);
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * insert, lookup and delete by key, rb_tree (parent links, bottom up
+ * fixups) versus rb_tdtree (no parent links, top down), for each tree
+ * size given on the command line
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree-topdown.h"
+#include "check.h"
+
+struct pentry {
+	struct rb_node node;
+	unsigned long key;
+};
+
+struct tentry {
+	struct rb_tdnode node;
+	unsigned long key;
+};
+
+#define P(n)	((struct pentry *)n)
+#define T(n)	((struct tentry *)n)
+
+static int pcmp(struct rb_node *l, struct rb_node *r)
+{
+	if (P(r)->key != P(l)->key)
+		return P(r)->key < P(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int pfind_cmp(struct rb_node *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	return (k > P(n)->key) - (k < P(n)->key);
+}
+
+static int tcmp(struct rb_tdnode *l, struct rb_tdnode *r)
+{
+	if (T(r)->key != T(l)->key)
+		return T(r)->key < T(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int tfind_cmp(struct rb_tdnode *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	return (k > T(n)->key) - (k < T(n)->key);
+}
+
+static void run(unsigned long n)
+{
+	struct pentry *pe = calloc(n, sizeof(*pe));
+	struct tentry *te = calloc(n, sizeof(*te));
+	unsigned long *keys = calloc(n, sizeof(*keys));
+	unsigned long i, found = 0;
+	struct rb_tree pt;
+	struct rb_tdtree tt;
+	double t0, t1, t2, t3;
+
+	if (!pe || !te || !keys) {
+		fprintf(stderr, "n=%lu: out of memory\n", n);
+		goto out;
+	}
+
+	srand(1);
+	for (i = 0; i < n; i++)
+		keys[i] = pe[i].key = te[i].key =
+			(unsigned long)rand() << 31 ^ rand();
+
+	rb_init(&pt);
+	t0 = now_ns();
+	for (i = 0; i < n; i++)
+		rb_insert(&pt, &pe[i].node, pcmp);
+	t1 = now_ns();
+	for (i = 0; i < n; i++)
+		found += !!rb_find(&pt, &keys[(i * 7) % n], pfind_cmp);
+	t2 = now_ns();
+	for (i = 0; i < n; i++) {
+		struct rb_node *node = rb_find(&pt, &keys[i], pfind_cmp);
+
+		if (node)
+			rb_delete(&pt, node);
+	}
+	t3 = now_ns();
+	printf("rb_tree    n=%lu: insert %.1f ns, find %.1f ns, delete %.1f ns, %zu bytes/node\n",
+		n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n,
+		sizeof(struct rb_node));
+
+	rb_td_init(&tt);
+	t0 = now_ns();
+	for (i = 0; i < n; i++)
+		rb_td_insert(&tt, &te[i].node, tcmp);
+	t1 = now_ns();
+	for (i = 0; i < n; i++)
+		found += !!rb_td_find(&tt, &keys[(i * 7) % n], tfind_cmp);
+	t2 = now_ns();
+	for (i = 0; i < n; i++)
+		rb_td_delete(&tt, &keys[i], tfind_cmp);
+	t3 = now_ns();
+	printf("rb_tdtree  n=%lu: insert %.1f ns, find %.1f ns, delete %.1f ns, %zu bytes/node\n",
+		n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n,
+		sizeof(struct rb_tdnode));
+
+	fprintf(stderr, "%lu\n", found);
+out:
+	free(pe);
+	free(te);
+	free(keys);
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	if (argc < 2) {
+		run(1000000);
+		return 0;
+	}
+
+	// e.g. bench-topdown 1000000 10000000 100000000
+	for (i = 1; i < argc; i++)
+		run(strtoul(argv[i], NULL, 0));
+	return 0;
+}
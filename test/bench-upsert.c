@@ -0,0 +1,103 @@
+/*
+ * upsert throughput: refreshing entries with rb_find() + rb_delete() +
+ * rb_insert() versus rb_find() + rb_replace(), and appending ascending
+ * keys with rb_insert() versus rb_insert_hint() on the last node
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+struct entry {
+	struct rb_node node;
+	unsigned long key;
+	unsigned long version;
+};
+
+#define E(n)	((struct entry *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (E(r)->key != E(l)->key)
+		return E(r)->key < E(l)->key ? -1 : 1;
+	return 0;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	unsigned long k = *(const unsigned long *)key;
+
+	return (k > E(n)->key) - (k < E(n)->key);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned long i, k;
+	struct entry *e = calloc(n * 2, sizeof(*e));
+	unsigned long *keys = calloc(n, sizeof(*keys));
+	struct rb_node *node, *hint;
+	struct rb_tree tree;
+	double t0, t1, t2;
+
+	if (!e || !keys)
+		return 1;
+
+	// n distinct keys, refreshed in random order
+	srand(1);
+	rb_init(&tree);
+	for (i = 0; i < n; i++) {
+		e[i].key = i * 2654435761UL;
+		rb_insert(&tree, &e[i].node, cmp);
+	}
+	for (i = 0; i < n; i++)
+		keys[i] = e[rand() % n].key;
+
+	// each round swaps e[k] and e[n + k], whichever is in the tree
+	t0 = now_ns();
+	for (i = 0; i < n; i++) {
+		node = rb_find(&tree, &keys[i], find_cmp);
+		k = E(node) - e;
+		k = k < n ? k + n : k - n;
+		e[k].key = keys[i];
+		e[k].version = i;
+		rb_delete(&tree, node);
+		rb_insert(&tree, &e[k].node, cmp);
+	}
+	t1 = now_ns();
+	for (i = 0; i < n; i++) {
+		node = rb_find(&tree, &keys[i], find_cmp);
+		k = E(node) - e;
+		k = k < n ? k + n : k - n;
+		e[k].key = keys[i];
+		e[k].version = i;
+		rb_replace(&tree, node, &e[k].node);
+	}
+	t2 = now_ns();
+	printf("refresh n=%lu: find + delete + insert %.1f ns, find + rb_replace %.1f ns\n",
+		n, (t1 - t0) / n, (t2 - t1) / n);
+
+	// ascending appends
+	rb_init(&tree);
+	t0 = now_ns();
+	for (i = 0; i < n; i++) {
+		e[i].key = i;
+		rb_insert(&tree, &e[i].node, cmp);
+	}
+	t1 = now_ns();
+	rb_init(&tree);
+	hint = NULL;
+	for (i = 0; i < n; i++) {
+		e[i].key = i;
+		rb_insert_hint(&tree, hint, &e[i].node, cmp);
+		hint = &e[i].node;
+	}
+	t2 = now_ns();
+	printf("append  n=%lu: rb_insert %.1f ns, rb_insert_hint %.1f ns\n",
+		n, (t1 - t0) / n, (t2 - t1) / n);
+
+	free(e);
+	free(keys);
+	return 0;
+}
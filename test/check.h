@@ -0,0 +1,58 @@
+/*
+ * shared helpers for the test programs
+ */
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../rbtree.h"
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", \
+			__FILE__, __LINE__, #cond); \
+		exit(1); \
+	} \
+} while (0)
+
+// verify the red black properties below node, return black height
+static inline int check_node(struct rb_node *node, struct rb_node *parent)
+{
+	int l, r;
+
+	if (!node)
+		return 0;
+
+	CHECK(rb_parent(node) == parent);
+	if (rb_color(node) == RB_RED)
+		CHECK(!parent || rb_color(parent) == RB_BLACK);
+
+	l = check_node(node->left, node);
+	r = check_node(node->right, node);
+	CHECK(l == r);
+
+	return l + (rb_color(node) == RB_BLACK);
+}
+
+static inline int check_tree(struct rb_tree *tree)
+{
+	if (tree->root)
+		CHECK(rb_color(tree->root) == RB_BLACK);
+	return check_node(tree->root, NULL);
+}
+
+// keep the compiler from hoisting loads out of benchmark loops
+#define barrier() __asm__ __volatile__("" ::: "memory")
+
+static inline double now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#endif
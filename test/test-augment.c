@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int in;
+	int w;			// per node weight
+	unsigned long size;	// augmented: subtree node count
+	int max;		// augmented: subtree max weight
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static inline unsigned long compute_size(struct my_node *n)
+{
+	return 1 + (n->node.left ? MY(n->node.left)->size : 0) +
+		(n->node.right ? MY(n->node.right)->size : 0);
+}
+
+static inline int compute_max(struct my_node *n)
+{
+	int max = n->w;
+
+	if (n->node.left && MY(n->node.left)->max > max)
+		max = MY(n->node.left)->max;
+	if (n->node.right && MY(n->node.right)->max > max)
+		max = MY(n->node.right)->max;
+	return max;
+}
+
+RB_DECLARE_CALLBACKS(static, size_cb, struct my_node, node,
+		unsigned long, size, compute_size)
+RB_DECLARE_CALLBACKS(static, max_cb, struct my_node, node,
+		int, max, compute_max)
+
+static struct my_node nodes[N];
+
+static int check_size(struct rb_node *node)
+{
+	if (!node)
+		return 1;
+	return check_size(node->left) && check_size(node->right) &&
+		MY(node)->size == compute_size(MY(node));
+}
+
+static int check_max(struct rb_node *node)
+{
+	if (!node)
+		return 1;
+	return check_max(node->left) && check_max(node->right) &&
+		MY(node)->max == compute_max(MY(node));
+}
+
+// size changes all the way up, max may stop propagating early
+static void run(const struct rb_augment_callbacks *aug,
+		int (*check)(struct rb_node *))
+{
+	struct rb_tree tree;
+	int i;
+
+	memset(nodes, 0, sizeof(nodes));
+	rb_init(&tree);
+
+	for (i = 0; i < N * 4; i++) {
+		struct my_node *x = &nodes[rand() % N];
+
+		if (x->in) {
+			rb_delete_augmented(&tree, &x->node, aug);
+			x->in = 0;
+		} else {
+			x->v = rand() % (N * 8);
+			x->w = rand() % 100;
+			x->size = 1;
+			x->max = x->w;
+			x->in = rb_insert_augmented(&tree, &x->node, cmp, aug);
+		}
+		check_tree(&tree);
+		CHECK(check(tree.root));
+	}
+}
+
+int main()
+{
+	int j;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		run(&size_cb, check_size);
+		run(&max_cb, check_max);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
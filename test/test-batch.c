@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 2000
+#define M 300
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+static struct rb_node *batch[N];
+static char present[N * 4];
+static int values[N * 4];
+static const void *keys[N * 4];
+static struct rb_node *found[N * 4];
+
+static void gen(int n, int mode)
+{
+	int i, base = rand() % (N * 4);
+
+	for (i = 0; i < n; i++) {
+		struct my_node *x = &nodes[i];
+
+		switch (mode) {
+		case 0:	// ascending
+			x->v = i * 2;
+			break;
+		case 1:	// descending
+			x->v = (n - i) * 2;
+			break;
+		case 2:	// clustered around a moving base
+			if (rand() % 50 == 0)
+				base = rand() % (N * 4);
+			x->v = (base + rand() % 16) % (N * 4);
+			break;
+		default:
+			x->v = rand() % (N * 4);
+			break;
+		}
+		batch[i] = &x->node;
+	}
+}
+
+int main()
+{
+	struct rb_tree tree;
+	struct rb_node *node;
+	size_t count, expect;
+	int i, j, n, prev;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		n = rand() % N;
+		gen(n, j % 4);
+
+		rb_init(&tree);
+		memset(present, 0, sizeof(present));
+		expect = 0;
+
+		// seed the tree with a first half inserted one by one
+		for (i = 0; i < n / 2; i++)
+			if (rb_insert(&tree, batch[i], cmp))
+				present[MY(batch[i])->v] = 1;
+
+		for (i = n / 2; i < n; i++)
+			if (!present[MY(batch[i])->v]) {
+				present[MY(batch[i])->v] = 1;
+				expect++;
+			}
+
+		count = rb_insert_batch(&tree, batch + n / 2, n - n / 2, cmp);
+		CHECK(count == expect);
+		check_tree(&tree);
+
+		// batched lookups of present and missing keys, any count
+		for (i = 0; i < N * 4; i++) {
+			values[i] = rand() % (N * 4 + 2) - 1;
+			keys[i] = &values[i];
+		}
+		n = rand() % (N * 4);
+		rb_find_batch(&tree, keys, n, find_cmp, found);
+		for (i = 0; i < n; i++)
+			CHECK(found[i] == rb_find(&tree, keys[i], find_cmp));
+
+		prev = -1;
+		rb_for_each(node, &tree) {
+			CHECK(MY(node)->v > prev);
+			CHECK(present[MY(node)->v]);
+			present[MY(node)->v] = 0;
+			prev = MY(node)->v;
+		}
+		for (i = 0; i < N * 4; i++)
+			CHECK(!present[i]);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
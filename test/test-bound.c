@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static struct my_node nodes[N];
+static struct rb_node *order[N];
+
+// with runs of equal keys floor is the last of the run, ceil the first
+static void multiset(void)
+{
+	struct rb_tree tree;
+	struct rb_node *n, *lb, *ub, *fl;
+	int i, k, m, u, count;
+
+	rb_init(&tree);
+	for (i = 0; i < N; i++) {
+		nodes[i].v = rand() % (N / 4);
+		rb_insert_multi(&tree, &nodes[i].node, cmp);
+	}
+	check_tree(&tree);
+
+	count = 0;
+	rb_for_each(n, &tree)
+		order[count++] = n;
+	CHECK(count == N);
+
+	for (i = 0; i < 500; i++) {
+		k = rand() % (N / 4 + 2) - 1;
+
+		// m is the first index not less than k, u the first greater
+		for (m = 0; m < count && MY(order[m])->v < k; m++)
+			;
+		for (u = m; u < count && MY(order[u])->v == k; u++)
+			;
+		lb = m < count ? order[m] : NULL;
+		ub = u < count ? order[u] : NULL;
+		fl = u ? order[u - 1] : NULL;
+
+		CHECK(rb_lower_bound(&tree, &k, find_cmp) == lb);
+		CHECK(rb_ceil(&tree, &k, find_cmp) == lb);
+		CHECK(rb_upper_bound(&tree, &k, find_cmp) == ub);
+		CHECK(rb_floor(&tree, &k, find_cmp) == fl);
+	}
+}
+
+int main()
+{
+	struct rb_node *n, *parent, **link, *lb, *ub, *fl;
+	struct rb_tree tree;
+	int i, j, k, m, count, inserted;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init(&tree);
+
+		// insert through rb_find_or_insert_pos() only
+		inserted = 0;
+		for (i = 0; i < N; i++) {
+			nodes[i].v = rand() % (N * 4);
+			n = rb_find_or_insert_pos(&tree, &nodes[i].v, find_cmp,
+					&parent, &link);
+			if (n) {
+				CHECK(MY(n)->v == nodes[i].v);
+				continue;
+			}
+			rb_link_node(&nodes[i].node, parent, link);
+			rb_insert_color(&tree, &nodes[i].node);
+			CHECK(rb_find(&tree, &nodes[i].v, find_cmp) ==
+					&nodes[i].node);
+			inserted++;
+		}
+		check_tree(&tree);
+
+		count = 0;
+		rb_for_each(n, &tree)
+			order[count++] = n;
+		CHECK(count == inserted);
+
+		for (i = 0; i < 500; i++) {
+			k = rand() % (N * 4 + 2) - 1;
+
+			// m is the first index not less than k
+			for (m = 0; m < count && MY(order[m])->v < k; m++)
+				;
+			lb = m < count ? order[m] : NULL;
+			if (lb && MY(lb)->v == k) {
+				ub = m + 1 < count ? order[m + 1] : NULL;
+				fl = lb;
+			}
+			else {
+				ub = lb;
+				fl = m ? order[m - 1] : NULL;
+			}
+
+			CHECK(rb_lower_bound(&tree, &k, find_cmp) == lb);
+			CHECK(rb_ceil(&tree, &k, find_cmp) == lb);
+			CHECK(rb_upper_bound(&tree, &k, find_cmp) == ub);
+			CHECK(rb_floor(&tree, &k, find_cmp) == fl);
+		}
+
+		multiset();
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
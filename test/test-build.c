@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 3000
+
+struct my_node {
+	struct rb_node node;
+	int v;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static struct my_node nodes[N];
+static struct rb_node *sorted[N];
+
+static void check_order(struct rb_tree *tree, int n)
+{
+	struct rb_node *node;
+	int i = 0;
+
+	check_tree(tree);
+	rb_for_each(node, tree)
+		CHECK(MY(node)->v == i++);
+	CHECK(i == n);
+}
+
+int main()
+{
+	struct rb_tree tree;
+	int i, n;
+
+	for (i = 0; i < N; i++) {
+		nodes[i].v = i;
+		sorted[i] = &nodes[i].node;
+	}
+
+	for (n = 0; n <= N; n++) {
+		rb_build_sorted(&tree, sorted, n);
+		check_order(&tree, n);
+
+		for (i = 0; i < n; i++)
+			nodes[i].node.right = i + 1 < n ? &nodes[i + 1].node : NULL;
+		rb_build_sorted_list(&tree, n ? &nodes[0].node : NULL);
+		check_order(&tree, n);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static struct my_node nodes[N];
+
+static void check_cached(struct rb_tree_cached *tree)
+{
+	struct rb_node *last = NULL, *n;
+
+	check_tree(&tree->tree);
+	rb_for_each(n, &tree->tree)
+		last = n;
+	CHECK(rb_first_cached(tree) == rb_first(&tree->tree));
+	CHECK(rb_last_cached(tree) == last);
+}
+
+int main()
+{
+	struct rb_tree_cached tree;
+	struct rb_node *n;
+	int i, j, prev;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init_cached(&tree);
+
+		for (i = 0; i < N * 4; i++) {
+			struct my_node *x = &nodes[rand() % N];
+
+			if (x->in) {
+				rb_delete_cached(&tree, &x->node);
+				x->in = 0;
+			} else {
+				x->v = rand() % (N * 8);
+				x->in = rb_insert_cached(&tree, &x->node, cmp);
+			}
+			check_cached(&tree);
+		}
+
+		prev = -1;
+		while ((n = rb_pop_first_cached(&tree))) {
+			CHECK(MY(n)->v > prev);
+			prev = MY(n)->v;
+			MY(n)->in = 0;
+			check_cached(&tree);
+		}
+		CHECK(rb_empty(&tree.tree));
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../rbtree-concurrent.h"
+#include "check.h"
+
+#define N 4096
+#define READERS 4
+#define WRITES 2000000
+
+struct my_node {
+	struct rb_node node;
+	int v;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int cmp_key(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct rb_ctree ctree;
+static struct my_node nodes[N];
+static int in[N];
+static int stop;
+
+// even keys stay in the tree, odd keys come and go
+static void *reader(void *arg)
+{
+	unsigned int seed = (unsigned long)arg;
+	unsigned long lookups = 0;
+	struct rb_node *node;
+	int key;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		key = rand_r(&seed) % N;
+		node = rb_ctree_find(&ctree, &key, cmp_key);
+		if (node)
+			CHECK(MY(node)->v == key);
+		else
+			CHECK(key % 2);
+		lookups++;
+	}
+
+	return (void *)lookups;
+}
+
+int main()
+{
+	pthread_t tids[READERS];
+	struct rb_node *node;
+	void *lookups;
+	int i, k;
+
+	srand(time(NULL));
+	rb_ctree_init(&ctree);
+
+	for (i = 0; i < N; i++) {
+		nodes[i].v = i;
+		if (i % 2 == 0) {
+			rb_ctree_insert(&ctree, &nodes[i].node, cmp);
+			in[i] = 1;
+		}
+	}
+
+	for (i = 0; i < READERS; i++)
+		pthread_create(&tids[i], NULL, reader, (void *)(long)rand());
+
+	for (i = 0; i < WRITES; i++) {
+		k = (rand() % (N / 2)) * 2 + 1;
+		if (in[k])
+			rb_ctree_delete(&ctree, &nodes[k].node);
+		else
+			rb_ctree_insert(&ctree, &nodes[k].node, cmp);
+		in[k] = !in[k];
+	}
+
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < READERS; i++) {
+		pthread_join(tids[i], &lookups);
+		CHECK(lookups != NULL);
+	}
+
+	// the result must be the same as the sequential tree
+	check_tree(&ctree.tree);
+	k = 0;
+	rb_for_each(node, &ctree.tree) {
+		CHECK(in[MY(node)->v]);
+		k++;
+	}
+	for (i = 0; i < N; i++)
+		k -= in[i];
+	CHECK(k == 0);
+
+	rb_ctree_destroy(&ctree);
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../rbtree-epoch.h"
+#include "check.h"
+
+#define N 1024
+#define READERS 3
+#define WRITES 1000000
+#define POISON -1
+
+struct my_node {
+	struct rb_node node;
+	struct rb_epoch_head head;
+	int v;
+	int freed;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int cmp_key(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct rb_ctree ctree;
+static struct rb_epoch domain;
+static struct my_node nodes[N * 2];
+static struct my_node *in[N];
+static struct my_node *free_list[N * 2];
+static int nfree;
+static int stop;
+
+// poison the node, a reader still holding it would notice
+static void free_node(struct rb_epoch_head *head)
+{
+	struct my_node *x = container_of(head, struct my_node, head);
+
+	__atomic_store_n(&x->v, POISON, __ATOMIC_RELAXED);
+	x->freed = 1;
+	free_list[nfree++] = x;
+}
+
+static void *reader(void *arg)
+{
+	unsigned int seed = (unsigned long)arg;
+	struct rb_epoch_thread thr;
+	struct rb_node *node;
+	int key, i;
+
+	rb_epoch_register(&domain, &thr);
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		key = rand_r(&seed) % N;
+		rb_epoch_enter(&thr);
+		node = rb_ctree_find(&ctree, &key, cmp_key);
+		// hold the node a while, it must stay valid
+		for (i = 0; node && i < 10; i++)
+			CHECK(__atomic_load_n(&MY(node)->v,
+				__ATOMIC_RELAXED) == key);
+		rb_epoch_exit(&thr);
+	}
+	rb_epoch_unregister(&thr);
+
+	return NULL;
+}
+
+int main()
+{
+	pthread_t tids[READERS];
+	struct rb_epoch_thread thr;
+	struct my_node *x;
+	int i, k;
+
+	srand(time(NULL));
+	rb_ctree_init(&ctree);
+	rb_epoch_init(&domain);
+	rb_epoch_register(&domain, &thr);
+
+	for (i = 0; i < N * 2; i++)
+		free_list[nfree++] = &nodes[i];
+
+	for (i = 0; i < READERS; i++)
+		pthread_create(&tids[i], NULL, reader, (void *)(long)rand());
+
+	for (i = 0; i < WRITES; i++) {
+		k = rand() % N;
+		if (in[k]) {
+			rb_delete_deferred(&ctree, &in[k]->node, &thr,
+					&in[k]->head, free_node);
+			in[k] = NULL;
+		} else if (nfree) {
+			x = free_list[--nfree];
+			x->v = k;
+			x->freed = 0;
+			rb_ctree_insert(&ctree, &x->node, cmp);
+			in[k] = x;
+		}
+	}
+
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < READERS; i++)
+		pthread_join(tids[i], NULL);
+
+	// every removed node is freed by the barrier
+	rb_epoch_barrier(&thr);
+	for (i = 0; i < N; i++)
+		if (in[i])
+			nfree++;
+	CHECK(nfree == N * 2);
+	check_tree(&ctree.tree);
+
+	rb_epoch_unregister(&thr);
+	rb_epoch_destroy(&domain);
+	rb_ctree_destroy(&ctree);
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,240 @@
+#include <map>
+#include <set>
+#include <string>
+#include "../rbtree.hpp"
+#include "check.h"
+
+#define N 1000
+#define M 50
+
+struct item {
+	int pad;
+	rb_node node;
+	int v;
+
+	bool operator<(const item &o) const { return v < o.v; }
+};
+
+// compares items with plain ints too
+struct item_less {
+	typedef void is_transparent;
+
+	bool operator()(const item &a, const item &b) const { return a.v < b.v; }
+	bool operator()(const item &a, int b) const { return a.v < b; }
+	bool operator()(int a, const item &b) const { return a < b.v; }
+};
+
+typedef rb::intrusive_set<item, &item::node, item_less> item_set;
+
+static item items[N];
+
+// not standard layout, offsetof() is not valid on it
+struct vitem {
+	virtual ~vitem() {}
+	std::string name;
+	rb_node node;
+	int v;
+
+	bool operator<(const vitem &o) const { return v < o.v; }
+};
+
+static void test_vitem()
+{
+	rb::intrusive_set<vitem, &vitem::node> set;
+	static vitem vitems[N];
+	int i, prev = -1;
+
+	for (i = 0; i < N; i++) {
+		vitems[i].v = (i * 7) % N;
+		vitems[i].name = std::to_string(vitems[i].v);
+		CHECK(set.insert(vitems[i]).second);
+	}
+	check_tree(set.c_tree());
+	for (const vitem &x : set) {
+		CHECK(x.v > prev && x.name == std::to_string(x.v));
+		prev = x.v;
+	}
+	CHECK(&*set.find(vitems[3]) == &vitems[3]);
+}
+
+// a polymorphic mapped type, the map's nodes are not standard layout
+struct vvalue {
+	virtual ~vvalue() {}
+	virtual int get() const { return v; }
+	int v;
+};
+
+static void test_vmap()
+{
+	rb::map<std::string, vvalue> map;
+	std::string prev;
+	int i;
+
+	for (i = 0; i < N; i++)
+		map[std::to_string((i * 7) % N)].v = (i * 7) % N;
+	check_tree(map.c_tree());
+	CHECK(map.size() == N);
+	for (const auto &x : map) {
+		CHECK(prev.empty() || prev < x.first);
+		CHECK(x.first == std::to_string(x.second.get()));
+		prev = x.first;
+	}
+	CHECK(map.find("3")->second.get() == 3);
+	CHECK(map.erase("3") == 1 && map.find("3") == map.end());
+	check_tree(map.c_tree());
+}
+
+static void test_set()
+{
+	item_set set;
+	const item_set &cset = set;
+	std::set<int> ref;
+	int i, j, k;
+
+	for (j = 0; j < M; j++) {
+		set.clear();
+		ref.clear();
+
+		for (i = 0; i < N * 2; i++) {
+			item *x = &items[rand() % N];
+
+			if (set.find(*x) != set.end() && &*set.find(*x) == x) {
+				set.erase(*x);
+				ref.erase(x->v);
+			} else if (set.find(*x) == set.end()) {
+				x->v = rand() % (N * 4);
+				CHECK(set.insert(*x).second == !ref.count(x->v));
+				ref.insert(x->v);
+			}
+			CHECK(set.size() == ref.size());
+
+			k = rand() % (N * 4);
+			CHECK(cset.contains(k) == !!ref.count(k));
+			auto lb = cset.lower_bound(k);
+			auto rlb = ref.lower_bound(k);
+			CHECK((lb == set.end()) == (rlb == ref.end()));
+			if (rlb != ref.end())
+				CHECK(lb->v == *rlb);
+			auto ub = set.upper_bound(k);
+			auto rub = ref.upper_bound(k);
+			CHECK((ub == set.end()) == (rub == ref.end()));
+			if (rub != ref.end())
+				CHECK(ub->v == *rub);
+			CHECK(cset.upper_bound(k) == ub);
+			CHECK(cset.find(k) == set.find(k));
+		}
+		check_tree(set.c_tree());
+
+		auto r = ref.begin();
+		for (const item &x : set)
+			CHECK(x.v == *r++);
+		CHECK(r == ref.end());
+
+		auto rr = ref.rbegin();
+		for (auto it = set.rbegin(); it != set.rend(); ++it)
+			CHECK(it->v == *rr++);
+		CHECK(rr == ref.rend());
+	}
+}
+
+static void test_map()
+{
+	rb::map<int, std::string> map;
+	const rb::map<int, std::string> &cmap = map;
+	std::map<int, std::string> ref;
+	int i, j, k;
+
+	for (j = 0; j < M; j++) {
+		for (i = 0; i < N * 2; i++) {
+			k = rand() % N;
+			switch (rand() % 5) {
+			case 0:
+				map[k] = std::to_string(i);
+				ref[k] = std::to_string(i);
+				break;
+			case 1:
+				CHECK(map.emplace(k, "e").second ==
+						ref.emplace(k, "e").second);
+				break;
+			case 2:
+				CHECK(map.try_emplace(k, 3, 't').second ==
+						ref.try_emplace(k, 3, 't').second);
+				break;
+			case 3:
+				CHECK(map.erase(k) == ref.erase(k));
+				break;
+			case 4: {
+				auto nh = map.extract(k);
+				auto rnh = ref.extract(k);
+				CHECK(nh.empty() == rnh.empty());
+				if (nh.empty())
+					break;
+				CHECK(nh.mapped() == rnh.mapped());
+				nh.key() = rnh.key() = k + N;
+				auto ret = map.insert(std::move(nh));
+				auto rret = ref.insert(std::move(rnh));
+				CHECK(ret.inserted == rret.inserted);
+				CHECK(ret.node.empty() == rret.node.empty());
+				break;
+			}
+			}
+			CHECK(map.size() == ref.size());
+			CHECK(map.count(k) == ref.count(k));
+			CHECK(cmap.lower_bound(k) == map.lower_bound(k));
+			CHECK(cmap.upper_bound(k) == map.upper_bound(k));
+			if (ref.count(k))
+				CHECK(map.at(k) == ref.at(k));
+		}
+		check_tree(map.c_tree());
+
+		auto r = ref.begin();
+		for (auto &kv : map) {
+			CHECK(kv.first == r->first && kv.second == r->second);
+			++r;
+		}
+		CHECK(r == ref.end());
+
+		auto it = map.end();
+		for (auto rr = ref.rbegin(); rr != ref.rend(); ++rr)
+			CHECK((--it)->first == rr->first);
+		CHECK(it == map.begin());
+
+		// copies are independent and balanced
+		rb::map<int, std::string> copy(map);
+		check_tree(copy.c_tree());
+		CHECK(copy.size() == map.size());
+		copy.clear();
+		CHECK(copy.empty() && map.size() == ref.size());
+		copy = map;
+		CHECK(copy.size() == map.size());
+
+		rb::map<int, std::string> moved(std::move(copy));
+		CHECK(copy.empty() && moved.size() == map.size());
+		for (auto &kv : map)
+			CHECK(moved.find(kv.first)->second == kv.second);
+
+		if (j % 2) {
+			map.clear();
+			ref.clear();
+		}
+	}
+
+	bool threw = false;
+	try {
+		map.at(-1);
+	} catch (const std::out_of_range &) {
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+int main()
+{
+	srand(time(NULL));
+	test_set();
+	test_map();
+	test_vitem();
+	test_vmap();
+	fprintf(stderr, "passed\n");
+	return 0;
+}
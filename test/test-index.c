@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-index.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	int v;
+	struct rb_inode node;
+	int in;
+};
+
+static struct my_node nodes[N + 1];
+
+#define MY(tree, i)	rb_ientry(tree, i, struct my_node, node)
+
+static int cmp(const struct rb_itree *tree, uint32_t a, uint32_t b)
+{
+	return MY(tree, b)->v - MY(tree, a)->v;
+}
+
+static int find_cmp(const struct rb_itree *tree, uint32_t i, const void *key)
+{
+	return *(const int *)key - MY(tree, i)->v;
+}
+
+static int check_inode(struct rb_itree *tree, uint32_t i, uint32_t parent)
+{
+	struct rb_inode *n = rb_inode(tree, i);
+	int l, r;
+
+	if (!i)
+		return 0;
+
+	CHECK(n->parent >> 1 == parent);
+	if ((n->parent & 1) == RB_RED)
+		CHECK(!parent || (rb_inode(tree, parent)->parent & 1) == RB_BLACK);
+
+	l = check_inode(tree, n->left, i);
+	r = check_inode(tree, n->right, i);
+	CHECK(l == r);
+
+	return l + ((n->parent & 1) == RB_BLACK);
+}
+
+static void check_itree(struct rb_itree *tree)
+{
+	if (tree->root)
+		CHECK((rb_inode(tree, tree->root)->parent & 1) == RB_BLACK);
+	check_inode(tree, tree->root, RB_INIL);
+}
+
+int main()
+{
+	struct rb_itree tree;
+	uint32_t i, x;
+	int j, k, count, prev;
+
+	srand(time(NULL));
+	CHECK(sizeof(struct rb_inode) == 12);
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_itree_init(&tree, nodes, sizeof(nodes[0]),
+				offsetof(struct my_node, node));
+		CHECK(rb_itree_empty(&tree));
+		count = 0;
+
+		for (k = 0; k < N * 4; k++) {
+			x = rand() % N + 1;
+			if (nodes[x].in) {
+				CHECK(rb_itree_find(&tree, &nodes[x].v, find_cmp) == x);
+				rb_itree_delete(&tree, x);
+				nodes[x].in = 0;
+				count--;
+			} else {
+				nodes[x].v = rand() % (N * 8);
+				nodes[x].in = rb_itree_insert(&tree, x, cmp);
+				count += nodes[x].in;
+				i = rb_itree_find(&tree, &nodes[x].v, find_cmp);
+				CHECK(i && nodes[i].v == nodes[x].v);
+			}
+			check_itree(&tree);
+		}
+
+		prev = -1;
+		k = 0;
+		rb_itree_for_each(i, &tree) {
+			CHECK(nodes[i].in && nodes[i].v > prev);
+			prev = nodes[i].v;
+			k++;
+		}
+		CHECK(k == count);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-inline.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int in;
+};
+
+#define my_key(x) ((x)->v)
+#define int_cmp(a, b) (((a) > (b)) - ((a) < (b)))
+
+RB_DECLARE_TREE(my, struct my_node, node, int, my_key, int_cmp)
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return int_cmp(*(const int *)key,
+			container_of(n, struct my_node, node)->v);
+}
+
+static struct my_node nodes[N];
+
+int main()
+{
+	struct rb_tree tree;
+	struct my_node *x, *next;
+	int i, j, k;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init(&tree);
+
+		for (i = 0; i < N * 4; i++) {
+			x = &nodes[rand() % N];
+			if (x->in) {
+				CHECK(my_find(&tree, x->v) == x);
+				rb_delete(&tree, &x->node);
+				x->in = 0;
+			} else {
+				x->v = rand() % (N * 8);
+				x->in = my_insert(&tree, x);
+				CHECK(my_find(&tree, x->v)->v == x->v);
+			}
+			check_tree(&tree);
+
+			k = rand() % (N * 8);
+			x = my_find(&tree, k);
+			CHECK(!x || x->v == k);
+			// the first node greater than k, not just any of them
+			next = my_next_from(&tree, k);
+			CHECK((next ? &next->node : NULL) ==
+					rb_next_from(&tree, &k, find_cmp));
+			CHECK(!next || next->v > k);
+		}
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
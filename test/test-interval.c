@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-interval.h"
+#include "check.h"
+
+#define N 500
+#define M 100
+#define RANGE 10000
+
+struct my_node {
+	struct rb_interval_node it;
+	int in;
+};
+
+static struct my_node nodes[N];
+
+static void check_query(struct rb_tree *tree, unsigned long start,
+		unsigned long last)
+{
+	struct rb_interval_node *it, *prev = NULL;
+	int i, expect = 0, got = 0;
+
+	for (i = 0; i < N; i++)
+		if (nodes[i].in && nodes[i].it.start <= last &&
+				start <= nodes[i].it.last)
+			expect++;
+
+	rb_interval_for_each(it, tree, start, last) {
+		CHECK(it->start <= last && start <= it->last);
+		CHECK(!prev || prev->start <= it->start);
+		prev = it;
+		got++;
+	}
+	CHECK(got == expect);
+}
+
+int main()
+{
+	struct rb_tree tree;
+	unsigned long s;
+	int i, j;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init(&tree);
+
+		for (i = 0; i < N * 4; i++) {
+			struct my_node *x = &nodes[rand() % N];
+
+			if (x->in) {
+				rb_interval_delete(&tree, &x->it);
+				x->in = 0;
+			} else {
+				x->it.start = rand() % RANGE;
+				// mostly short, some long intervals
+				x->it.last = x->it.start + (rand() % 8 ?
+					rand() % 50 : rand() % RANGE);
+				rb_interval_insert(&tree, &x->it);
+				x->in = 1;
+			}
+			check_tree(&tree);
+			s = rand() % RANGE;
+			check_query(&tree, s, s + rand() % 100);
+		}
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
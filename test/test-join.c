@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 2000
+#define M 2000
+
+struct my_node {
+	struct rb_node node;
+	int v;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int cmp_key(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+
+// check order and bounds, returns the node count
+static int check_range(struct rb_tree *tree, int lo, int hi)
+{
+	struct rb_node *node;
+	int prev = lo, count = 0;
+
+	check_tree(tree);
+	rb_for_each(node, tree) {
+		CHECK(MY(node)->v > prev && MY(node)->v < hi);
+		prev = MY(node)->v;
+		count++;
+	}
+	return count;
+}
+
+int main()
+{
+	struct rb_tree tree, lo, hi;
+	struct rb_node *found;
+	int i, j, n, key, a, b;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		n = rand() % N;
+		rb_init(&tree);
+		for (i = 0; i < n; i++) {
+			nodes[i].v = rand() % (N * 4);
+			if (!rb_insert(&tree, &nodes[i].node, cmp))
+				nodes[i].v = -1;
+		}
+		n = check_range(&tree, -1, N * 4);
+
+		key = rand() % (N * 4);
+		found = rb_split(&tree, &key, cmp_key, &lo, &hi);
+		CHECK(rb_empty(&tree));
+		CHECK(!found || MY(found)->v == key);
+		a = check_range(&lo, -1, key);
+		b = check_range(&hi, key, N * 4);
+		CHECK(a + b + !!found == n);
+
+		// join back, with or without the pivot
+		if (found)
+			rb_join(&lo, found, &hi);
+		else
+			rb_join(&lo, NULL, &hi);
+		CHECK(rb_empty(&hi));
+		CHECK(check_range(&lo, -1, N * 4) == n);
+
+		// split in place and join trees of different heights
+		key = rand() % (N * 4);
+		found = rb_split(&lo, &key, cmp_key, &lo, &hi);
+		a = check_range(&lo, -1, key);
+		b = check_range(&hi, key, N * 4);
+		rb_join(&lo, found, &hi);
+		CHECK(check_range(&lo, -1, N * 4) == a + b + !!found);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+#define KEYS 50
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int seq;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+
+int main()
+{
+	struct rb_tree tree;
+	struct rb_node *n, *first, *last;
+	int i, j, k, seq, count[KEYS], total, run;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		memset(count, 0, sizeof(count));
+		rb_init(&tree);
+		seq = 0;
+
+		for (i = 0; i < N * 4; i++) {
+			struct my_node *x = &nodes[rand() % N];
+
+			if (x->in) {
+				rb_delete(&tree, &x->node);
+				count[x->v]--;
+				x->in = 0;
+			} else {
+				x->v = rand() % KEYS;
+				x->seq = seq++;
+				rb_insert_multi(&tree, &x->node, cmp);
+				count[x->v]++;
+				x->in = 1;
+			}
+		}
+		check_tree(&tree);
+
+		// sorted by key, equal keys in insertion order
+		total = 0;
+		for (n = rb_first(&tree); n; n = rb_next(n)) {
+			struct rb_node *next = rb_next(n);
+
+			if (next && MY(next)->v == MY(n)->v)
+				CHECK(MY(next)->seq > MY(n)->seq);
+			else if (next)
+				CHECK(MY(next)->v > MY(n)->v);
+			total++;
+		}
+
+		for (k = -1; k <= KEYS; k++) {
+			first = rb_equal_range(&tree, &k, find_cmp, &last);
+			if (k < 0 || k == KEYS || !count[k]) {
+				CHECK(!first && !last);
+				continue;
+			}
+			CHECK(first && last);
+			CHECK(first == rb_lower_bound(&tree, &k, find_cmp));
+			CHECK(rb_next(last) == rb_upper_bound(&tree, &k, find_cmp));
+
+			run = 1;
+			for (n = first; n != last; n = rb_next(n)) {
+				CHECK(MY(n)->v == k);
+				run++;
+			}
+			CHECK(run == count[k]);
+			total -= run;
+		}
+		CHECK(total == 0);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-order.h"
+#include "check.h"
+
+#define N 500
+#define M 200
+
+struct my_node {
+	struct rb_order_node node;
+	int v;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int cmp_key(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+
+static void check_order(struct rb_tree *tree)
+{
+	struct rb_node *n;
+	unsigned long i = 0;
+	int key;
+
+	check_tree(tree);
+	rb_for_each(n, tree) {
+		CHECK(rb_select(tree, i) == n);
+		CHECK(rb_rank(tree, n) == i);
+		CHECK(rb_count_less(tree, &MY(n)->v, cmp_key) == i);
+		key = MY(n)->v + 1;
+		CHECK(rb_count_less(tree, &key, cmp_key) == i + 1);
+		i++;
+	}
+	CHECK(rb_order_size(tree) == i);
+	CHECK(rb_select(tree, i) == NULL);
+
+	// a node of another tree
+	if (tree->root) {
+		struct rb_tree other = { NULL };
+
+		CHECK(rb_rank(&other, tree->root) == ULONG_MAX);
+	}
+}
+
+int main()
+{
+	struct rb_tree tree;
+	int i, j;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init(&tree);
+
+		for (i = 0; i < N * 4; i++) {
+			struct my_node *x = &nodes[rand() % N];
+
+			if (x->in) {
+				rb_order_delete(&tree, &x->node);
+				x->in = 0;
+			} else {
+				x->v = (rand() % (N * 8)) * 2;
+				x->in = rb_order_insert(&tree, &x->node, cmp);
+			}
+			if (i % 16 == 0)
+				check_order(&tree);
+		}
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
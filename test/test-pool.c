@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-pool.h"
+#include "check.h"
+
+#define N 1000
+#define M 50
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int live;
+	char pad[9];
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static void run(int flags, size_t chunk_size)
+{
+	struct rb_pool pool;
+	struct rb_tree tree;
+	struct my_node *x;
+	struct rb_node *n;
+	static char in[N * 4];
+	int i, j, k, count;
+
+	CHECK(rb_pool_init(&pool, sizeof(struct my_node), chunk_size,
+				flags) == 0);
+	CHECK(pool.size % 16 == 0);
+
+	for (j = 0; j < M; j++) {
+		rb_init(&tree);
+		memset(in, 0, sizeof(in));
+		count = 0;
+
+		for (i = 0; i < N * 4; i++) {
+			k = rand() % (N * 4);
+			if (in[k]) {
+				n = rb_find(&tree, &k, find_cmp);
+				CHECK(n && MY(n)->v == k);
+				rb_delete(&tree, n);
+				memset(n, 0xa5, sizeof(struct my_node));
+				rb_pool_free(&pool, n);
+				in[k] = 0;
+				count--;
+			} else {
+				x = rb_pool_alloc(&pool);
+				CHECK(x);
+				CHECK((unsigned long)x % 16 == 0);
+				x->v = k;
+				CHECK(rb_insert(&tree, &x->node, cmp));
+				in[k] = 1;
+				count++;
+			}
+		}
+		check_tree(&tree);
+
+		// live nodes were not overwritten by the free list
+		k = -1;
+		i = 0;
+		rb_for_each(n, &tree) {
+			CHECK(MY(n)->v > k && in[MY(n)->v]);
+			k = MY(n)->v;
+			i++;
+		}
+		CHECK(i == count);
+		CHECK(pool.nr_chunks);
+
+		rb_destroy(&tree, &pool);
+		CHECK(rb_empty(&tree));
+		CHECK(pool.nr_chunks == 0 && !pool.free);
+	}
+
+	// objects larger than a chunk are refused
+	CHECK(rb_pool_init(&pool, chunk_size ? chunk_size : 1 << 30, chunk_size,
+				flags) == -1);
+}
+
+#define THREADS 4
+
+static struct rb_pool shared;
+static struct rb_tree trees[THREADS];
+
+// each thread keeps a tree of its own, its nodes from one shared pool
+static void *worker(void *arg)
+{
+	struct rb_tree *tree = arg;
+	struct rb_pool_cache cache;
+	unsigned int seed = tree - trees;
+	struct my_node *x;
+	struct rb_node *n;
+	char in[N];
+	int i, k;
+
+	rb_pool_cache_init(&cache, &shared);
+	memset(in, 0, sizeof(in));
+	for (i = 0; i < N * 20; i++) {
+		k = rand_r(&seed) % N;
+		if (in[k]) {
+			n = rb_find(tree, &k, find_cmp);
+			CHECK(n && MY(n)->live);
+			rb_delete(tree, n);
+			MY(n)->live = 0;
+			rb_pool_cache_free(&cache, n);
+			in[k] = 0;
+		} else {
+			x = rb_pool_cache_alloc(&cache);
+			CHECK(x && !x->live);
+			CHECK((unsigned long)x % 16 == 0);
+			x->live = 1;
+			x->v = k;
+			CHECK(rb_insert(tree, &x->node, cmp));
+			in[k] = 1;
+		}
+	}
+	rb_pool_cache_flush(&cache);
+	CHECK(!cache.free && !cache.nr_free);
+	return NULL;
+}
+
+static void run_threads(void)
+{
+	pthread_t threads[THREADS];
+	struct rb_pool_cache cache;
+	struct rb_node *n, *next;
+	size_t nr_free = 0;
+	void *obj;
+	int i;
+
+	CHECK(rb_pool_init(&shared, sizeof(struct my_node), 4096, 0) == 0);
+	for (i = 0; i < THREADS; i++) {
+		rb_init(&trees[i]);
+		CHECK(pthread_create(&threads[i], NULL, worker, &trees[i]) == 0);
+	}
+	for (i = 0; i < THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	// nodes are freed by a thread other than the one that got them
+	rb_pool_cache_init(&cache, &shared);
+	for (i = 0; i < THREADS; i++) {
+		check_tree(&trees[i]);
+		for (n = rb_first_postorder(&trees[i]); n; n = next) {
+			next = rb_next_postorder(n);
+			CHECK(MY(n)->live);
+			MY(n)->live = 0;
+			rb_pool_cache_free(&cache, n);
+		}
+	}
+	rb_pool_cache_flush(&cache);
+
+	// everything handed out came back, each object once. a second
+	// visit would find live == 2
+	for (obj = shared.free; obj; obj = *(void **)obj) {
+		CHECK(!((struct my_node *)obj)->live);
+		((struct my_node *)obj)->live = 2;
+		nr_free++;
+	}
+	// a chunk holds a 16 byte header, then its objects
+	CHECK(nr_free == shared.nr_chunks * ((4096 - 16) / shared.size) -
+			(shared.end - shared.next) / shared.size);
+	rb_pool_destroy(&shared);
+}
+
+int main()
+{
+	srand(time(NULL));
+
+	run(0, 0);
+	run(0, 256);
+	run(RB_POOL_HUGEPAGE, 0);
+	run_threads();
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
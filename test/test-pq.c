@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-pq.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int seq;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static struct my_node nodes[N];
+
+static int min_key(void)
+{
+	int i, min = -1;
+
+	for (i = 0; i < N; i++)
+		if (nodes[i].in && (min < 0 || nodes[i].v < min))
+			min = nodes[i].v;
+	return min;
+}
+
+int main()
+{
+	struct rb_pq pq;
+	struct rb_node *n;
+	int i, j, op, count, min;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_pq_init(&pq, cmp);
+		count = 0;
+
+		for (i = 0; i < N * 4; i++) {
+			struct my_node *x = &nodes[rand() % N];
+
+			op = rand() % 4;
+			if (!x->in && op) {
+				x->v = rand() % (N / 4);
+				rb_pq_insert(&pq, &x->node);
+				x->in = 1;
+				count++;
+			} else if (!x->in) {
+				min = min_key();
+				n = rb_pq_pop_min(&pq);
+				if (min < 0) {
+					CHECK(!n);
+					continue;
+				}
+				CHECK(n && MY(n)->v == min);
+				MY(n)->in = 0;
+				count--;
+			} else if (op == 1) {
+				rb_pq_delete(&pq, &x->node);
+				x->in = 0;
+				count--;
+			} else if (x->v) {
+				x->v -= rand() % x->v + 1;
+				rb_pq_decrease_key(&pq, &x->node);
+			}
+
+			CHECK(rb_pq_peek(&pq) == rb_first(&pq.tree));
+			if (count)
+				CHECK(MY(rb_pq_peek(&pq))->v == min_key());
+		}
+		check_tree(&pq.tree);
+
+		// drain, keys come out sorted
+		min = 0;
+		while ((n = rb_pq_pop_min(&pq))) {
+			CHECK(MY(n)->v >= min);
+			min = MY(n)->v;
+			CHECK(rb_pq_peek(&pq) == rb_first(&pq.tree));
+			count--;
+		}
+		CHECK(count == 0 && rb_pq_empty(&pq));
+
+		// equal keys are popped in insertion order
+		for (i = 0; i < N; i++) {
+			nodes[i].v = rand() % 8;
+			nodes[i].seq = i;
+			rb_pq_insert(&pq, &nodes[i].node);
+		}
+		check_tree(&pq.tree);
+		n = rb_pq_pop_min(&pq);
+		for (i = 1; i < N; i++) {
+			struct rb_node *next = rb_pq_pop_min(&pq);
+
+			CHECK(MY(next)->v > MY(n)->v ||
+				(MY(next)->v == MY(n)->v && MY(next)->seq > MY(n)->seq));
+			n = next;
+			if (i % 64 == 0)
+				check_tree(&pq.tree);
+		}
+		CHECK(rb_pq_empty(&pq));
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 2000
+#define M 300
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int in;
+	int freed;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+static int nr_dropped;
+
+static void drop(struct rb_node *n)
+{
+	CHECK(!MY(n)->freed);
+	MY(n)->freed = 1;
+	nr_dropped++;
+}
+
+// a range well past RANGE_SMALL goes through split and join
+static void large_range(void)
+{
+	struct rb_tree tree;
+	struct rb_node *n;
+	int i, lo = 100, hi = 1100;
+
+	memset(nodes, 0, sizeof(nodes));
+	rb_init(&tree);
+	for (i = 0; i < N; i++) {
+		nodes[i].v = i;
+		CHECK(rb_insert(&tree, &nodes[i].node, cmp));
+	}
+
+	nr_dropped = 0;
+	CHECK(rb_delete_range(&tree, &lo, &hi, find_cmp, drop) ==
+			(size_t)(hi - lo));
+	CHECK(nr_dropped == hi - lo);
+	check_tree(&tree);
+
+	i = 0;
+	rb_for_each(n, &tree) {
+		CHECK(MY(n)->v == i);
+		CHECK(!MY(n)->freed);
+		i = i + 1 == lo ? hi : i + 1;
+	}
+	CHECK(i == N);
+	for (i = 0; i < N; i++)
+		CHECK(nodes[i].freed == (i >= lo && i < hi));
+}
+
+int main()
+{
+	struct rb_range_iter iter;
+	struct rb_tree tree;
+	struct rb_node *n;
+	int i, j, lo, hi, prev, count, expect;
+	size_t deleted;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init(&tree);
+		for (i = 0; i < N; i++) {
+			nodes[i].v = rand() % (N * 4);
+			nodes[i].in = rb_insert(&tree, &nodes[i].node, cmp);
+		}
+
+		// small and large ranges, empty and inverted ones too
+		lo = rand() % (N * 4 + 2) - 1;
+		switch (j % 4) {
+		case 0:
+			hi = lo + rand() % 40;
+			break;
+		case 1:
+			hi = lo + rand() % (N * 4);
+			break;
+		case 2:
+			hi = lo;
+			break;
+		default:
+			hi = lo - rand() % 10;
+			break;
+		}
+
+		expect = 0;
+		for (i = 0; i < N; i++)
+			expect += nodes[i].in && nodes[i].v >= lo && nodes[i].v < hi;
+
+		prev = lo - 1;
+		count = 0;
+		rb_for_each_range(n, &iter, &tree, &lo, &hi, find_cmp) {
+			CHECK(MY(n)->v > prev && MY(n)->v < hi);
+			prev = MY(n)->v;
+			count++;
+		}
+		CHECK(count == expect);
+
+		// the iterator survives deleting the current node. the
+		// method does not depend on the range kind, j % 4
+		if ((j / 4) % 2) {
+			rb_for_each_range(n, &iter, &tree, &lo, &hi, find_cmp) {
+				rb_delete(&tree, n);
+				drop(n);
+			}
+			deleted = count;
+		}
+		else
+			deleted = rb_delete_range(&tree, &lo, &hi, find_cmp, drop);
+		CHECK(deleted == (size_t)expect);
+		check_tree(&tree);
+
+		count = 0;
+		for (i = 0; i < N; i++) {
+			int gone = nodes[i].in && nodes[i].v >= lo && nodes[i].v < hi;
+
+			CHECK(nodes[i].freed == gone);
+			if (nodes[i].in && !gone) {
+				CHECK(rb_find(&tree, &nodes[i].v, find_cmp) ==
+						&nodes[i].node);
+				count++;
+			}
+		}
+		rb_for_each(n, &tree)
+			count--;
+		CHECK(count == 0);
+	}
+
+	large_range();
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+static struct my_node copies[N];
+static struct rb_node *in[N];
+
+static void check_order(struct rb_tree *tree, int count)
+{
+	struct rb_node *n, *prev = NULL;
+
+	check_tree(tree);
+	rb_for_each(n, tree) {
+		if (prev)
+			CHECK(MY(prev)->v < MY(n)->v);
+		prev = n;
+		count--;
+	}
+	CHECK(count == 0);
+}
+
+int main()
+{
+	struct rb_tree tree;
+	struct rb_node *hint, *n;
+	int i, j, k, count, v;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		memset(copies, 0, sizeof(copies));
+		rb_init(&tree);
+
+		// hints: none, a random node, or the last one inserted
+		count = 0;
+		hint = NULL;
+		for (i = 0; i < N; i++) {
+			nodes[i].v = rand() % (N * 4);
+			if (rand() % 2 && count)
+				hint = in[rand() % count];
+			if (rb_insert_hint(&tree, hint, &nodes[i].node, cmp)) {
+				CHECK(rb_find(&tree, &nodes[i].v, find_cmp) ==
+						&nodes[i].node);
+				hint = in[count++] = &nodes[i].node;
+			} else {
+				n = rb_find(&tree, &nodes[i].v, find_cmp);
+				CHECK(n && n != &nodes[i].node);
+			}
+		}
+		check_order(&tree, count);
+
+		// ascending run, each hinted by the one before
+		rb_init(&tree);
+		hint = NULL;
+		for (i = 0; i < N; i++) {
+			nodes[i].v = i * 2;
+			CHECK(rb_insert_hint(&tree, hint, &nodes[i].node, cmp));
+			hint = &nodes[i].node;
+		}
+		check_order(&tree, N);
+
+		// swap random nodes for copies, back and forth
+		for (i = 0; i < N; i++) {
+			k = rand() % N;
+			v = k * 2;
+			n = rb_find(&tree, &v, find_cmp);
+			CHECK(n);
+			if (n == &nodes[k].node) {
+				copies[k].v = v;
+				rb_replace(&tree, n, &copies[k].node);
+			} else {
+				CHECK(n == &copies[k].node);
+				rb_replace(&tree, n, &nodes[k].node);
+			}
+			CHECK(rb_find(&tree, &v, find_cmp) != n);
+		}
+		check_order(&tree, N);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+static struct rb_node *order[N];
+
+int main()
+{
+	struct rb_tree tree;
+	struct rb_node *n, *want;
+	struct my_node *pos;
+	int i, j, k, m, count;
+
+	srand(time(NULL));
+
+	rb_init(&tree);
+	CHECK(!rb_last(&tree));
+	k = 0;
+	CHECK(!rb_prev_from(&tree, &k, find_cmp));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_init(&tree);
+
+		for (i = 0; i < N; i++) {
+			nodes[i].v = rand() % (N * 4);
+			nodes[i].in = rb_insert(&tree, &nodes[i].node, cmp);
+		}
+		for (i = 0; i < N / 2; i++) {
+			k = rand() % N;
+			if (nodes[k].in) {
+				rb_delete(&tree, &nodes[k].node);
+				nodes[k].in = 0;
+			}
+		}
+
+		count = 0;
+		rb_for_each(n, &tree)
+			order[count++] = n;
+
+		// backwards is forwards reversed
+		i = count;
+		rb_for_each_reverse(n, &tree)
+			CHECK(n == order[--i]);
+		CHECK(i == 0);
+
+		i = count;
+		rb_for_each_entry_reverse(pos, &tree, node)
+			CHECK(&pos->node == order[--i]);
+		CHECK(i == 0);
+
+		CHECK(rb_last(&tree) == (count ? order[count - 1] : NULL));
+		if (count)
+			CHECK(rb_prev(order[0]) == NULL);
+
+		// the greatest node below k and the least above it
+		for (i = 0; i < 200; i++) {
+			k = rand() % (N * 4 + 2) - 1;
+			want = NULL;
+			for (m = 0; m < count && MY(order[m])->v < k; m++)
+				want = order[m];
+			CHECK(rb_prev_from(&tree, &k, find_cmp) == want);
+			if (m < count && MY(order[m])->v == k)
+				m++;
+			CHECK(rb_next_from(&tree, &k, find_cmp) ==
+					(m < count ? order[m] : NULL));
+		}
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-setop.h"
+#include "check.h"
+
+#define N 3000
+#define M 300
+#define RANGE (N * 2)
+
+struct my_node {
+	struct rb_node node;
+	int v;
+	int tree;	// 1 or 2, 0 once dropped
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static void drop(struct rb_node *node)
+{
+	__atomic_store_n(&MY(node)->tree, 0, __ATOMIC_RELAXED);
+}
+
+static struct my_node nodes[2][N];
+static char in[2][RANGE];
+
+static void fill(struct rb_tree *tree, int t, int n)
+{
+	int i;
+
+	rb_init(tree);
+	memset(in[t], 0, RANGE);
+	memset(nodes[t], 0, sizeof(nodes[t]));
+	for (i = 0; i < n; i++) {
+		struct my_node *x = &nodes[t][i];
+
+		x->v = rand() % RANGE;
+		x->tree = t + 1;
+		if (rb_insert(tree, &x->node, cmp))
+			in[t][x->v] = 1;
+		else
+			x->tree = 0;
+	}
+}
+
+static void check_result(struct rb_tree *tree, int kind)
+{
+	struct rb_node *node;
+	int v, prev = -1, count = 0, expect = 0;
+	int i, t;
+
+	check_tree(tree);
+	rb_for_each(node, tree) {
+		v = MY(node)->v;
+		CHECK(v > prev);
+		prev = v;
+		count++;
+		// the node of t1 wins
+		CHECK(MY(node)->tree == (in[0][v] ? 1 : 2));
+		if (kind == 0)
+			CHECK(in[0][v] || in[1][v]);
+		else if (kind == 1)
+			CHECK(in[0][v] && in[1][v]);
+		else
+			CHECK(in[0][v] && !in[1][v]);
+	}
+
+	for (v = 0; v < RANGE; v++) {
+		if (kind == 0)
+			expect += in[0][v] || in[1][v];
+		else if (kind == 1)
+			expect += in[0][v] && in[1][v];
+		else
+			expect += in[0][v] && !in[1][v];
+	}
+	CHECK(count == expect);
+
+	// every node is either in the result or dropped
+	for (t = 0; t < 2; t++)
+		for (i = 0; i < N; i++)
+			count -= nodes[t][i].tree != 0;
+	CHECK(count == 0);
+}
+
+int main()
+{
+	struct rb_threads pool;
+	struct rb_tree t1, t2;
+	int j, kind, threads;
+
+	srand(time(NULL));
+
+	for (threads = 0; threads <= 3; threads += 3) {
+		CHECK(rb_threads_init(&pool, threads) == 0);
+		for (j = 0; j < M; j++) {
+			kind = j % 3;
+			fill(&t1, 0, rand() % N);
+			fill(&t2, 1, rand() % N);
+
+			if (kind == 0)
+				rb_union(&t1, &t2, cmp, drop, &pool);
+			else if (kind == 1)
+				rb_intersect(&t1, &t2, cmp, drop, &pool);
+			else
+				rb_difference(&t1, &t2, cmp, drop, &pool);
+
+			CHECK(rb_empty(&t2));
+			check_result(&t1, kind);
+		}
+		rb_threads_destroy(&pool);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../rbtree-snapshot.h"
+#include "check.h"
+
+#define N 5000
+#define M 200
+
+struct my_node {
+	struct rb_node node;
+	uint64_t v;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_node *l, struct rb_node *r)
+{
+	if (MY(r)->v != MY(l)->v)
+		return MY(r)->v < MY(l)->v ? -1 : 1;
+	return 0;
+}
+
+static int find_cmp(struct rb_node *n, const void *key)
+{
+	uint64_t k = *(const uint64_t *)key;
+
+	return (k > MY(n)->v) - (k < MY(n)->v);
+}
+
+static uint64_t key(struct rb_node *n)
+{
+	return MY(n)->v;
+}
+
+static struct my_node nodes[N];
+
+static uint64_t random_key(uint64_t range)
+{
+	uint64_t k = (uint64_t)rand() << 33 ^ (uint64_t)rand() << 2 ^ rand();
+
+	return range ? k % range : k;
+}
+
+// every block search the cpu has gives the answers of the tree
+static void check_key(struct rb_tree *tree, struct rb_snapshot *snap,
+		uint64_t k)
+{
+	struct rb_node *found = rb_find(tree, &k, find_cmp);
+	struct rb_node *next = rb_next_from(tree, &k, find_cmp);
+	struct rb_node *lb = found ? found : next;
+	size_t i;
+	int isa;
+
+	for (isa = RB_SNAPSHOT_SCALAR; isa <= RB_SNAPSHOT_AVX2; isa++) {
+		if (rb_snapshot_use(snap, isa))
+			continue;
+		CHECK(rb_snapshot_find(snap, k) == found);
+		CHECK(rb_snapshot_next_from(snap, k) == next);
+		i = rb_snapshot_lower_bound(snap, k);
+		CHECK(i <= snap->n);
+		CHECK((i < snap->n ? snap->nodes[i] : NULL) == lb);
+	}
+}
+
+static void run(int n, uint64_t range)
+{
+	struct rb_snapshot snap;
+	struct rb_tree tree;
+	int i;
+
+	memset(nodes, 0, sizeof(nodes));
+	rb_init(&tree);
+	for (i = 0; i < n; i++) {
+		nodes[i].v = random_key(range);
+		rb_insert(&tree, &nodes[i].node, cmp);
+	}
+	// the extremes are keys too
+	if (n > 2) {
+		nodes[0].v = 0;
+		nodes[1].v = UINT64_MAX;
+		rb_init(&tree);
+		for (i = 0; i < n; i++)
+			rb_insert(&tree, &nodes[i].node, cmp);
+	}
+
+	CHECK(rb_snapshot_build(&snap, &tree, key) == 0);
+
+	for (i = 0; i < n; i++) {
+		check_key(&tree, &snap, nodes[i].v);
+		check_key(&tree, &snap, nodes[i].v - 1);
+		check_key(&tree, &snap, nodes[i].v + 1);
+	}
+	for (i = 0; i < 1000; i++)
+		check_key(&tree, &snap, random_key(range));
+	check_key(&tree, &snap, 0);
+	check_key(&tree, &snap, UINT64_MAX);
+
+	rb_snapshot_destroy(&snap);
+}
+
+int main()
+{
+	static const int sizes[] = { 0, 1, 2, 7, 8, 9, 63, 64, 65, 512, 513, N };
+	unsigned int i;
+	int j;
+
+	srand(time(NULL));
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		run(sizes[i], 0);
+		run(sizes[i], sizes[i] * 3 + 1);
+	}
+	for (j = 0; j < M; j++)
+		run(rand() % N, rand() % 2 ? 0 : N * 4);
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
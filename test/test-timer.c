@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../rbtree-timer.h"
+#include "check.h"
+
+#define N 1000
+#define M 50
+#define SHIFT 4
+// far enough to reach the overflow list
+#define MAX_DELAY ((RB_TIMER_WHEEL_SIZE << SHIFT) * 3)
+
+struct my_timer {
+	struct rb_timer timer;
+	int pending;
+	int fired;
+};
+
+#define MY(t)	((struct my_timer *)t)
+
+static struct my_timer timers[N];
+static struct rb_timer *out[64];
+static unsigned long now, last_fired;
+
+static void fire(struct rb_timer *t)
+{
+	CHECK(MY(t)->pending);
+	CHECK(t->expires <= now);
+	CHECK(t->expires >= last_fired);
+	CHECK(!rb_timer_pending(t));
+	last_fired = t->expires;
+	MY(t)->pending = 0;
+	MY(t)->fired++;
+}
+
+static void check_next(struct rb_timer_base *base)
+{
+	unsigned long min = ULONG_MAX, next = rb_timer_next(base);
+	size_t count = 0;
+	int i;
+
+	for (i = 0; i < N; i++) {
+		CHECK(!!timers[i].pending == !!rb_timer_pending(&timers[i].timer));
+		if (!timers[i].pending)
+			continue;
+		count++;
+		if (timers[i].timer.expires < min)
+			min = timers[i].timer.expires;
+	}
+	CHECK(count == base->count);
+	CHECK(next <= min);
+	if (min >> SHIFT <= base->slot)
+		CHECK(next == min);
+}
+
+int main()
+{
+	struct rb_timer_base base;
+	int i, j, k, batch;
+	size_t n, m;
+
+	srand(time(NULL));
+
+	for (j = 0; j < M; j++) {
+		memset(timers, 0, sizeof(timers));
+		now = rand() % 100000 + 8;
+		batch = j % 2;
+		rb_timer_base_init(&base, now, SHIFT);
+		for (i = 0; i < N; i++)
+			rb_timer_init(&timers[i].timer, fire);
+
+		for (k = 0; k < 2000; k++) {
+			for (i = 0; i < 20; i++) {
+				struct my_timer *x = &timers[rand() % N];
+
+				if (x->pending && rand() % 4 == 0) {
+					CHECK(rb_timer_cancel(&base, &x->timer));
+					x->pending = 0;
+				} else {
+					// may be overdue, may be rearmed
+					rb_timer_arm(&base, &x->timer,
+						now + rand() % MAX_DELAY - 8);
+					x->pending = 1;
+				}
+			}
+			check_next(&base);
+
+			// small steps, sometimes a jump over many slots. what
+			// is due fires now, the rest later
+			if (rand() % 50)
+				now += rand() % 40;
+			else
+				now += rand() % (MAX_DELAY * 2);
+			last_fired = 0;
+			if (batch) {
+				while ((m = rb_timer_expire_batch(&base, now, out, 64))) {
+					for (n = 0; n < m; n++)
+						fire(out[n]);
+					if (m < 64)
+						break;
+				}
+			} else {
+				rb_timer_expire(&base, now);
+			}
+
+			for (i = 0; i < N; i++)
+				CHECK(!timers[i].pending ||
+					timers[i].timer.expires > now);
+			check_next(&base);
+		}
+		check_tree(&base.near.tree);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../rbtree-topdown.h"
+#include "check.h"
+
+#define N 1000
+#define M 200
+
+struct my_node {
+	struct rb_tdnode node;
+	int v;
+	int in;
+};
+
+#define MY(n)       ((struct my_node *)n)
+
+static int cmp(struct rb_tdnode *l, struct rb_tdnode *r)
+{
+	return MY(r)->v - MY(l)->v;
+}
+
+static int find_cmp(struct rb_tdnode *n, const void *key)
+{
+	return *(const int *)key - MY(n)->v;
+}
+
+static struct my_node nodes[N];
+
+static int is_black(struct rb_tdnode *n)
+{
+	return (n->left & 1) == RB_BLACK;
+}
+
+// red black properties and order below node, returns black height
+static int check_tdnode(struct rb_tdnode *node, int red_parent,
+		int lo, int hi)
+{
+	int l, r;
+
+	if (!node)
+		return 0;
+
+	CHECK(!red_parent || is_black(node));
+	CHECK(MY(node)->v > lo && MY(node)->v < hi);
+
+	l = check_tdnode(rb_td_left(node), !is_black(node), lo, MY(node)->v);
+	r = check_tdnode(node->right, !is_black(node), MY(node)->v, hi);
+	CHECK(l == r);
+
+	return l + is_black(node);
+}
+
+static void check_tdtree(struct rb_tdtree *tree)
+{
+	if (tree->root)
+		CHECK(is_black(tree->root));
+	check_tdnode(tree->root, 0, -1, N * 8);
+}
+
+int main()
+{
+	struct rb_tdtree tree;
+	struct rb_td_iter iter;
+	struct rb_tdnode *n;
+	struct my_node *x;
+	int i, j, k, count, prev;
+
+	srand(time(NULL));
+	CHECK(sizeof(struct rb_tdnode) == 2 * sizeof(void *));
+
+	for (j = 0; j < M; j++) {
+		memset(nodes, 0, sizeof(nodes));
+		rb_td_init(&tree);
+		count = 0;
+
+		for (i = 0; i < N * 4; i++) {
+			x = &nodes[rand() % N];
+			if (x->in) {
+				CHECK(rb_td_find(&tree, &x->v, find_cmp) == &x->node);
+				CHECK(rb_td_delete(&tree, &x->v, find_cmp) == &x->node);
+				CHECK(!rb_td_find(&tree, &x->v, find_cmp));
+				x->in = 0;
+				count--;
+			} else {
+				x->v = rand() % (N * 8);
+				x->in = rb_td_insert(&tree, &x->node, cmp);
+				count += x->in;
+				n = rb_td_find(&tree, &x->v, find_cmp);
+				CHECK(n && MY(n)->v == x->v);
+			}
+
+			// missing keys are not removed
+			k = -1;
+			CHECK(!rb_td_delete(&tree, &k, find_cmp));
+			check_tdtree(&tree);
+		}
+
+		prev = -1;
+		k = 0;
+		rb_td_for_each(n, &iter, &tree) {
+			CHECK(MY(n)->in && MY(n)->v > prev);
+			prev = MY(n)->v;
+			k++;
+		}
+		CHECK(k == count);
+	}
+
+	fprintf(stderr, "passed\n");
+	return 0;
+}